@@ -3,7 +3,7 @@
 #ifndef APP_H
 #define APP_H
 
-void app_hrs_update(uint16_t val);
+void app_hrs_update(uint32_t chunk, uint16_t val);
 
 void app_ndn_update(const char *data, size_t len);
 
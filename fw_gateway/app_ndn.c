@@ -9,6 +9,7 @@
 #include "net/gnrc/pktbuf.h"
 #include "net/gnrc/netif.h"
 #include "ccn-lite-riot.h"
+#include "ndn_merkle.h"
 
 #define BUF_SIZE                (64U)
 #define PRIO                    (THREAD_PRIORITY_MAIN -1)
@@ -19,6 +20,7 @@ static char _stack[STACKSIZE];
 static uint8_t _scratchpad[BUF_SIZE];
 static gnrc_netreg_entry_t _reg;
 static msg_t _mq[MQSIZE];
+static ndn_merkle_cache_t _roots;
 
 static void *_on_data(void *arg)
 {
@@ -39,12 +41,20 @@ static void *_on_data(void *arg)
             else {
                 printf("[NDN] received Content (size %i)\n", (int)snip->size);
                 uint8_t *data = (uint8_t *)snip->data;
-                if (snip->size == 2) {
-                    app_hrs_update((uint16_t)data[0]);
+                uint32_t chunk;
+                int len = ndn_merkle_verify(&_roots, data, snip->size, &chunk);
+                if (len == NDN_MERKLE_INVALID) {
+                    puts("[NDN] dropping Data with invalid batch signature");
+                }
+                else if (len == 2) {
+                    printf("[NDN] verified heart rate chunk %u\n",
+                           (unsigned)chunk);
+                    app_hrs_update(chunk, (uint16_t)data[0]);
                 }
                 else {
                     /* this content belongs to some other interest... */
-                    app_ndn_update((const char *)snip->data, snip->size);
+                    app_ndn_update((const char *)snip->data,
+                                   (len >= 0) ? (size_t)len : snip->size);
                 }
             }
             gnrc_pktbuf_release(snip);
@@ -87,6 +97,10 @@ void app_ndn_init(void)
     int res = ccnl_open_netif(netif->pid, GNRC_NETTYPE_CCN);
     assert(res >= 0);
 
+    /* remember verified batch roots, so only the first chunk of each batch
+     * needs its tag checked */
+    ndn_merkle_cache_init(&_roots);
+
     /* open a thread to handle incoming NDN traffic */
     kernel_pid_t pid = thread_create(_stack, sizeof(_stack), PRIO, 0,
                                      _on_data, NULL, "ndn-data-handler");
@@ -22,6 +22,7 @@
 #include <stdint.h>
 
 #include "fmt.h"
+#include "irq.h"
 #include "shell.h"
 #include "assert.h"
 #include "event/timeout.h"
@@ -38,6 +39,12 @@
 #include "services/gap/ble_svc_gap.h"
 #include "services/gatt/ble_svc_gatt.h"
 
+#include "energy.h"
+#include "ndn_trace.h"
+#include "ndn_prio.h"
+#include "ndn_fib.h"
+#include "ndn_merkle.h"
+
 #include "app.h"
 
 #define HRS_FLAGS_DEFAULT       (0x01)      /* 16-bit BPM value */
@@ -50,8 +57,12 @@
 #define NSTATE_HRS              (0x0001)
 #define NSTATE_NDN              (0x0002)
 
+/* energy accounting slot used for the GATT connection to the smart phone */
+#define ENERGY_SLOT_GATT        (NIMBLE_NETIF_MAX_CONN)
+
 #define HRS_NAME_BUFSIZE        (32U)
 #define HRS_NAME_BASE           "/icn19/watch/hrs/"
+#define HRS_PRIO_CLASS          (0U)        /* heart rate is real-time */
 
 static const ble_uuid128_t _uuid_ndn_svc = BLE_UUID128_INIT(
                                 0x94, 0xc0, 0x8e, 0x7a, 0x9c, 0xa0, 0x45, 0x38,
@@ -79,6 +90,7 @@ static uint16_t _noti_state;
 
 static char _hrs_name[HRS_NAME_BUFSIZE];
 static const char *_hrs_name_base = HRS_NAME_BASE;
+/* written by NimBLE's thread, read by the NDN data thread */
 static uint32_t _hrs_chunk_id = 0;
 static char _namebuf[HRS_NAME_BUFSIZE];
 
@@ -197,6 +209,8 @@ static int _ndn_handler(uint16_t conn_handle, uint16_t attr_handle,
         (void)res;
         _namebuf[om_len] = '\0';
 
+        ndn_trace_add(NDN_TRACE_GATT_WRITE, 0, _namebuf);
+
         /* send out an interest using that name */
         printf("[WRITE] send out interest for '%s'\n", _namebuf);
         app_ndn_send_interest(_namebuf);
@@ -285,9 +299,12 @@ static int _gap_event_cb(struct ble_gap_event *event, void *arg)
                 return 0;
             }
             _conn_handle = event->connect.conn_handle;
+            energy_phase(ENERGY_PHASE_GATT_ADV, 0);
+            energy_conn_gap(ENERGY_SLOT_GATT, _conn_handle);
             break;
 
         case BLE_GAP_EVENT_DISCONNECT:
+            energy_conn(ENERGY_SLOT_GATT, 0);
             _start_advertising();
             break;
 
@@ -301,6 +318,7 @@ static int _gap_event_cb(struct ble_gap_event *event, void *arg)
             break;
 
         case BLE_GAP_EVENT_CONN_UPDATE:
+            energy_conn_gap(ENERGY_SLOT_GATT, event->conn_update.conn_handle);
             break;
     }
 
@@ -321,10 +339,12 @@ static void _start_advertising(void)
                             &advp, _gap_event_cb, NULL);
     assert(res == 0);
     (void)res;
+    energy_phase(ENERGY_PHASE_GATT_ADV, 1);
 }
 
 static void _ndn_conn(uint8_t state)
 {
+    ndn_trace_add(NDN_TRACE_GATT_SUB, state, "ndn");
     if (state != 1) {
         _noti_state &= ~NSTATE_NDN;
         puts("[NOTIFY_NDN] disabled");
@@ -337,6 +357,7 @@ static void _ndn_conn(uint8_t state)
 
 static void _hrs_conn(uint8_t state)
 {
+    ndn_trace_add(NDN_TRACE_GATT_SUB, state, "hrs");
     if (state != 1) {
         _noti_state &= ~NSTATE_HRS;
         ble_npl_callout_stop(&_hrs_update_evt);
@@ -354,11 +375,13 @@ static void _hrs_update_trigger(struct ble_npl_event *ev)
     (void)ev;
 
     printf("[NOTIFY_HRS] sending interest\n");
-    _hrs_chunk_id++;
+    unsigned state = irq_disable();
+    uint32_t chunk = ++_hrs_chunk_id;
+    irq_restore(state);
 
     size_t pos = strlen(_hrs_name_base);
     memcpy(_hrs_name, _hrs_name_base, pos);
-    pos += fmt_u32_dec((_hrs_name + pos), _hrs_chunk_id);
+    pos += fmt_u32_dec((_hrs_name + pos), chunk);
     _hrs_name[pos] = '\0';
     printf("interest to name: %s\n", _hrs_name);
     app_ndn_send_interest(_hrs_name);
@@ -367,8 +390,19 @@ static void _hrs_update_trigger(struct ble_npl_event *ev)
     ble_npl_callout_reset(&_hrs_update_evt, _hrs_updt_itvl);
 }
 
-void app_hrs_update(uint16_t bpm)
+void app_hrs_update(uint32_t chunk, uint16_t bpm)
 {
+    /* the signature only proves which chunk the sample was produced for, so
+     * make sure it is the one we asked for and not an older one replayed */
+    unsigned state = irq_disable();
+    uint32_t requested = _hrs_chunk_id;
+    irq_restore(state);
+    if (chunk != requested) {
+        printf("[NOTIFY_HRS] dropping chunk %u, requested %u\n",
+               (unsigned)chunk, (unsigned)requested);
+        return;
+    }
+
     printf("[NOTIFY_HRS] send new datum: %i\n", (int)bpm);
 
     struct os_mbuf *om;
@@ -450,6 +484,12 @@ static int _cmd_autoconn_wl(int argc, char **argv)
 
 static const shell_command_t _cmds[] = {
     { "wl", "while list BLE addresses", _cmd_autoconn_wl },
+    { "energy", "print radio and CPU energy statistics", energy_cmd },
+    { "trace", "record and dump a trace of the NDN workload", ndn_trace_cmd },
+    { "prio", "configure NDN traffic classes and show queue stats", ndn_prio_cmd },
+    { "fib", "add, remove and list static NDN routes", ndn_fib_cmd },
+    { "fibbench", "benchmark trie against linear route lookups", ndn_fib_bench_cmd },
+    { "merklebench", "benchmark batch signatures against per-packet HMAC", ndn_merkle_bench_cmd },
     { NULL, NULL, NULL }
 };
 
@@ -476,12 +516,27 @@ int main(void)
     /* reload the GATT server to link our added services */
     ble_gatts_start();
 
+    /* start energy accounting and tracing before any NDN traffic is
+     * processed */
+    energy_init();
+    ndn_trace_init();
+
+    /* protect the heart rate Interests from bulk requests by the phone */
+    ndn_prio_init();
+    res = ndn_prio_add(HRS_NAME_BASE, HRS_PRIO_CLASS);
+    assert(res == 0);
+
+    /* static routes, installed through the shell */
+    ndn_fib_init();
+
     /* setup NDN (CCN-lite) */
     app_ndn_init();
 
     /* run autoconn */
     nimble_autoconn_init(&nimble_autoconn_params, NULL, 0);
+    nimble_autoconn_eventcb(energy_on_netif_evt);
     nimble_autoconn_enable();
+    energy_autoconn(&nimble_autoconn_params);
 
     /* configure and set the advertising data */
     uint8_t buf[BLE_HS_ADV_MAX_SZ];
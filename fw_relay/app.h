@@ -0,0 +1,11 @@
+
+
+#ifndef APP_H
+#define APP_H
+
+void app_cache_init(void);
+
+int app_cache_cmd(int argc, char **argv);
+
+
+#endif /* APP_H */
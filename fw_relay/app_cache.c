@@ -0,0 +1,245 @@
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "app.h"
+#include "mutex.h"
+#include "random.h"
+#include "ndn_tap.h"
+#include "ccn-lite-riot.h"
+#include "ccnl-callbacks.h"
+#ifdef MODULE_NDN_IDX
+#include "ndn_idx.h"
+#endif
+
+/* count-min sketch dimensions, counters are halved every SKETCH_AGING
+ * recorded Interests so old popularity fades out */
+#define SKETCH_ROWS             (3U)
+#define SKETCH_COLS             (64U)
+#define SKETCH_AGING            (256U)
+#define SKETCH_MAX              (UINT8_MAX)
+
+#define PROB_DEFAULT            (50U)       /* in percent */
+#define POP_DEFAULT             (2U)        /* requested at least twice */
+
+typedef enum {
+    POLICY_ALWAYS,
+    POLICY_PROB,
+    POLICY_POP,
+} policy_t;
+
+static const char *_policy_str[] = { "always", "prob", "pop" };
+
+static policy_t _policy = POLICY_ALWAYS;
+static unsigned _prob = PROB_DEFAULT;
+static unsigned _pop = POP_DEFAULT;
+
+static uint8_t _sketch[SKETCH_ROWS][SKETCH_COLS];
+static unsigned _sketch_cnt = 0;
+
+static struct {
+    uint32_t interests;
+    uint32_t hits;
+    uint32_t admitted;
+    uint32_t rejected;
+} _stats;
+
+static mutex_t _lock = MUTEX_INIT;
+static ndn_tap_t _tap;
+
+/* FNV-1a, seeded differently for each sketch row */
+static uint32_t _hash(unsigned row, const uint8_t *name, size_t len)
+{
+    uint32_t hash = 2166136261u ^ (row * 0x9e3779b9u);
+    for (size_t i = 0; i < len; i++) {
+        hash = (hash ^ name[i]) * 16777619u;
+    }
+    return hash;
+}
+
+static void _sketch_inc(const uint8_t *name, size_t len)
+{
+    for (unsigned row = 0; row < SKETCH_ROWS; row++) {
+        uint8_t *cnt = &_sketch[row][_hash(row, name, len) % SKETCH_COLS];
+        if (*cnt < SKETCH_MAX) {
+            (*cnt)++;
+        }
+    }
+
+    if (++_sketch_cnt >= SKETCH_AGING) {
+        _sketch_cnt = 0;
+        for (unsigned row = 0; row < SKETCH_ROWS; row++) {
+            for (unsigned col = 0; col < SKETCH_COLS; col++) {
+                _sketch[row][col] >>= 1;
+            }
+        }
+    }
+}
+
+static unsigned _sketch_get(const uint8_t *name, size_t len)
+{
+    unsigned min = SKETCH_MAX;
+    for (unsigned row = 0; row < SKETCH_ROWS; row++) {
+        uint8_t cnt = _sketch[row][_hash(row, name, len) % SKETCH_COLS];
+        if (cnt < min) {
+            min = cnt;
+        }
+    }
+    return min;
+}
+
+/* check if the content store holds Data with exactly the given (TLV encoded)
+ * name. CCN-lite would also answer an Interest with Data whose name the
+ * Interest's name is a prefix of, but all Interests in this setup name exact
+ * chunks, so such prefix hits are not counted */
+static int _in_cs(const uint8_t *name, size_t len)
+{
+#ifdef MODULE_NDN_IDX
+    return (ndn_idx_cs_get(name, len) != NULL);
+#else
+    for (struct ccnl_content_s *c = ccnl_relay.contents; c; c = c->next) {
+        ndn_tap_pkt_t pkt;
+        if ((c->pkt->buf != NULL) &&
+            (ndn_tap_parse(c->pkt->buf->data, c->pkt->buf->datalen, &pkt) == 0) &&
+            (pkt.name_len == len) && (memcmp(pkt.name, name, len) == 0)) {
+            return 1;
+        }
+    }
+    return 0;
+#endif
+}
+
+static void _on_pkt(const ndn_tap_evt_t *evt, void *arg)
+{
+    (void)arg;
+    ndn_tap_pkt_t pkt;
+
+    if ((evt->dir != NDN_TAP_RX) || (evt->cls != NDN_TAP_CLS_INTEREST) ||
+        (ndn_tap_parse(evt->data, evt->len, &pkt) != 0)) {
+        return;
+    }
+
+    /* we are called after CCN-lite processed the Interest: if the CS holds
+     * matching Data now, the Interest was answered from the cache */
+    int hit = _in_cs(pkt.name, pkt.name_len);
+
+    mutex_lock(&_lock);
+    _stats.interests++;
+    _stats.hits += hit;
+    _sketch_inc(pkt.name, pkt.name_len);
+    mutex_unlock(&_lock);
+}
+
+static int _admit(struct ccnl_relay_s *relay, struct ccnl_content_s *c)
+{
+    (void)relay;
+    ndn_tap_pkt_t pkt;
+    int res = 1;
+
+    mutex_lock(&_lock);
+    switch (_policy) {
+        case POLICY_PROB:
+            res = (random_uint32_range(0, 100) < _prob);
+            break;
+        case POLICY_POP:
+            res = ((c->pkt->buf != NULL) &&
+                   (ndn_tap_parse(c->pkt->buf->data, c->pkt->buf->datalen,
+                                  &pkt) == 0) &&
+                   (_sketch_get(pkt.name, pkt.name_len) >= _pop));
+            break;
+        default:
+            break;
+    }
+    if (res) {
+        _stats.admitted++;
+    }
+    else {
+        _stats.rejected++;
+    }
+    mutex_unlock(&_lock);
+
+    return res;
+}
+
+void app_cache_init(void)
+{
+    _tap.cb = _on_pkt;
+    _tap.arg = NULL;
+    ndn_tap_register(&_tap);
+
+    ccnl_set_cache_strategy_cache(_admit);
+}
+
+static void _print(void)
+{
+    mutex_lock(&_lock);
+    printf("cache: policy %s", _policy_str[_policy]);
+    if (_policy == POLICY_PROB) {
+        printf(" (%u%%)", _prob);
+    }
+    else if (_policy == POLICY_POP) {
+        printf(" (>= %u requests)", _pop);
+    }
+    unsigned rate = (_stats.interests) ?
+                    (unsigned)(((uint64_t)_stats.hits * 100) / _stats.interests) : 0;
+    printf("\n       %lu interests, %lu hits (%u%%)\n",
+           (unsigned long)_stats.interests, (unsigned long)_stats.hits, rate);
+    printf("       %lu data admitted, %lu rejected\n",
+           (unsigned long)_stats.admitted, (unsigned long)_stats.rejected);
+    mutex_unlock(&_lock);
+}
+
+int app_cache_cmd(int argc, char **argv)
+{
+    if (argc < 2) {
+        _print();
+        return 0;
+    }
+
+    if (strcmp(argv[1], "reset") == 0) {
+        mutex_lock(&_lock);
+        memset(&_stats, 0, sizeof(_stats));
+        mutex_unlock(&_lock);
+        return 0;
+    }
+
+    policy_t policy = POLICY_ALWAYS;
+    int val = -1;
+    if ((strcmp(argv[1], "policy") == 0) && (argc > 2)) {
+        unsigned numof = sizeof(_policy_str) / sizeof(_policy_str[0]);
+        for (unsigned i = 0; i < numof; i++) {
+            if (strcmp(argv[2], _policy_str[i]) == 0) {
+                policy = (policy_t)i;
+                val = 0;
+            }
+        }
+        if ((val == 0) && (argc > 3)) {
+            val = atoi(argv[3]);
+            if (((policy == POLICY_PROB) && (val > 100)) ||
+                ((policy == POLICY_POP) && (val > SKETCH_MAX))) {
+                val = -1;
+            }
+        }
+    }
+    if (val < 0) {
+        printf("usage: %s [reset|policy always|prob [<pct, 0-100>]"
+               "|pop [<min, 0-%u>]]\n", argv[0], (unsigned)SKETCH_MAX);
+        return 1;
+    }
+
+    mutex_lock(&_lock);
+    _policy = policy;
+    if (policy == POLICY_PROB) {
+        _prob = (argc > 3) ? (unsigned)val : PROB_DEFAULT;
+    }
+    else if (policy == POLICY_POP) {
+        _pop = (argc > 3) ? (unsigned)val : POP_DEFAULT;
+    }
+    /* compare policies on equal terms */
+    memset(&_stats, 0, sizeof(_stats));
+    mutex_unlock(&_lock);
+
+    return 0;
+}
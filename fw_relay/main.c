@@ -24,20 +24,60 @@
 #include "shell.h"
 #include "ccn-lite-riot.h"
 #include "net/gnrc/netif.h"
+#include "nimble_autoconn.h"
+#include "nimble_autoconn_params.h"
+
+#include "energy.h"
+#include "ndn_idx.h"
+#include "ndn_prio.h"
+#include "ndn_fib.h"
+
+#include "app.h"
 
 // REMOVE
 #include "net/gnrc/pktdump.h"
 
+/* heart rate traffic is served with the highest priority */
+#define HRS_PREFIX          "/icn19/watch/hrs"
+#define HRS_PRIO_CLASS      (0U)
+
 /* main thread's message queue */
 #define MAIN_QUEUE_SIZE     (8)
 static msg_t _main_msg_queue[MAIN_QUEUE_SIZE];
 
+static const shell_command_t _cmds[] = {
+    { "energy", "print radio and CPU energy statistics", energy_cmd },
+    { "idxbench", "benchmark hashed against linear name lookups", ndn_idx_bench_cmd },
+    { "prio", "configure NDN traffic classes and show queue stats", ndn_prio_cmd },
+    { "cache", "select the caching policy and show CS hit rates", app_cache_cmd },
+    { "fib", "add, remove and list static NDN routes", ndn_fib_cmd },
+    { "fibbench", "benchmark trie against linear route lookups", ndn_fib_bench_cmd },
+    { NULL, NULL, NULL }
+};
+
 int main(void)
 {
     msg_init_queue(_main_msg_queue, MAIN_QUEUE_SIZE);
 
     puts("NDN-BLE-Demo: Relay Node");
 
+    /* track energy spent on connections and on forwarding */
+    energy_init();
+    nimble_autoconn_eventcb(energy_on_netif_evt);
+    energy_autoconn(&nimble_autoconn_params);
+
+    /* schedule forwarded packets by traffic class */
+    ndn_prio_init();
+    if (ndn_prio_add(HRS_PREFIX, HRS_PRIO_CLASS) != 0) {
+        puts("Error configuring traffic classes!");
+    }
+
+    /* decide which Data is worth caching */
+    app_cache_init();
+
+    /* static routes, installed through the shell */
+    ndn_fib_init();
+
     ccnl_core_init();
     ccnl_start();
 
@@ -57,6 +97,6 @@ int main(void)
 
     /* run the shell */
     char line_buf[SHELL_DEFAULT_BUFSIZE];
-    shell_run(NULL, line_buf, SHELL_DEFAULT_BUFSIZE);
+    shell_run(_cmds, line_buf, SHELL_DEFAULT_BUFSIZE);
     return 0;
 }
@@ -0,0 +1,45 @@
+#!/bin/sh
+#
+# Replay the same trace against multiple builds of fw_replay and print the
+# difference of each result to the first build.
+#
+# usage: compare.sh <trace> <speed> <elf> [<elf> ...]
+
+if [ $# -lt 3 ]; then
+    echo "usage: $0 <trace> <speed> <elf> [<elf> ...]"
+    exit 1
+fi
+
+TRACE=$1
+SPEED=$2
+shift 2
+
+BASE=""
+for ELF in "$@"; do
+    RES=$( (cat "${TRACE}"; echo "replay run ${SPEED} exit") | \
+           "${ELF}" | grep '^RESULT')
+    if [ -z "${RES}" ]; then
+        echo "${ELF}: no result"
+        continue
+    fi
+    if [ -z "${BASE}" ]; then
+        BASE=${RES}
+        echo "${ELF} (baseline): ${RES#RESULT }"
+        continue
+    fi
+    echo "${ELF}:"
+    echo "${BASE} ${RES}" | awk '{
+        n = (NF / 2)
+        for (i = 2; i <= n; i++) {
+            split($i, b, "=")
+            split($(n + i), r, "=")
+            if (b[2] == 0) {
+                d = (r[2] == 0) ? "+0.0%" : "n/a"
+            }
+            else {
+                d = sprintf("%+.1f%%", ((r[2] - b[2]) * 100) / b[2])
+            }
+            printf("    %-5s %10s -> %10s  %s\n", b[1], b[2], r[2], d)
+        }
+    }'
+done
@@ -0,0 +1,53 @@
+/*
+ * Copyright (C) 2019 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     examples
+ * @{
+ *
+ * @file
+ * @brief       NDN-BLE-Demo: replay recorded gateway workloads on native
+ *
+ * @author      Hauke Petersen <hauke.petersen@fu-berlin.de>
+ *
+ * @}
+ */
+
+#include <stdio.h>
+
+#include "msg.h"
+#include "shell.h"
+#include "ccn-lite-riot.h"
+
+#include "replay.h"
+
+/* main thread's message queue */
+#define MAIN_QUEUE_SIZE     (8)
+static msg_t _main_msg_queue[MAIN_QUEUE_SIZE];
+
+static const shell_command_t _cmds[] = {
+    { "replay", "load and replay a recorded NDN trace", replay_cmd },
+    { NULL, NULL, NULL }
+};
+
+int main(void)
+{
+    msg_init_queue(_main_msg_queue, MAIN_QUEUE_SIZE);
+
+    puts("NDN-BLE-Demo: Replay Node");
+
+    ccnl_core_init();
+    ccnl_start();
+
+    replay_init();
+
+    /* run the shell */
+    char line_buf[SHELL_DEFAULT_BUFSIZE];
+    shell_run(_cmds, line_buf, SHELL_DEFAULT_BUFSIZE);
+    return 0;
+}
@@ -0,0 +1,418 @@
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "assert.h"
+#include "mutex.h"
+#include "xtimer.h"
+#include "periph/pm.h"
+#include "net/gnrc/pktbuf.h"
+#include "net/gnrc/netreg.h"
+#include "ccn-lite-riot.h"
+#include "ccnl-producer.h"
+#include "ndn_trace.h"
+
+#include "replay.h"
+
+#define EVENTS_MAX              (1024U)
+#define TIMEOUT                 (1000U * US_PER_MS)
+#define POLL_ITVL               (10U * US_PER_MS)
+#define DATA_LEN_MIN            (2U)        /* we need to fit the event id */
+#define DATA_LEN_MAX            (256U)
+#define BUF_SIZE                (64U)
+#define PRIO                    (THREAD_PRIORITY_MAIN - 1)
+#define STACKSIZE               (THREAD_STACKSIZE_DEFAULT)
+#define MQSIZE                  (16U)
+
+enum {
+    EVT_IDLE,
+    EVT_PENDING,
+    EVT_DONE,
+};
+
+typedef struct {
+    uint32_t time;
+    uint32_t sent;
+    uint32_t latency;
+    uint16_t arg;
+    uint8_t type;
+    uint8_t state;
+    char name[NDN_TRACE_NAMELEN + 1];
+} event_t;
+
+static event_t _evts[EVENTS_MAX];
+static unsigned _numof = 0;
+static mutex_t _lock = MUTEX_INIT;
+static uint32_t _lat[EVENTS_MAX];
+static uint32_t _last_rx;
+static uint32_t _rx_bytes;
+
+static char _stack[STACKSIZE];
+static msg_t _mq[MQSIZE];
+static gnrc_netreg_entry_t _reg;
+static uint8_t _scratchpad[BUF_SIZE];
+static unsigned char _csbuf[CCNL_MAX_PACKET_SIZE];
+static uint8_t _content[DATA_LEN_MAX];
+
+/* get the oldest pending Interest for the given name */
+static int _find_pending(const char *name)
+{
+    for (unsigned i = 0; i < _numof; i++) {
+        if ((_evts[i].state == EVT_PENDING) &&
+            (strcmp(_evts[i].name, name) == 0)) {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+static void _prefix_to_uri(struct ccnl_prefix_s *p, char *buf, size_t size)
+{
+    size_t pos = 0;
+
+    for (unsigned i = 0; i < p->compcnt; i++) {
+        if ((pos + p->complen[i] + 2) > size) {
+            break;
+        }
+        buf[pos++] = '/';
+        memcpy(&buf[pos], p->comp[i], p->complen[i]);
+        pos += p->complen[i];
+    }
+    buf[pos] = '\0';
+}
+
+static void _cs_insert(struct ccnl_relay_s *relay, struct ccnl_prefix_s *prefix,
+                       void *payload, size_t payload_len)
+{
+    int res;
+    (void)res;  /* in case we build without develhelp */
+
+    /* generate a NDN-TLV item */
+    size_t offs = sizeof(_csbuf);
+    size_t reslen = 0;
+    res = ccnl_ndntlv_prependContent(prefix, payload, payload_len,
+                                     NULL, NULL, &offs, _csbuf, &reslen);
+    assert(res == 0);
+
+    /* and add it into the content store */
+    size_t len;
+    uint64_t type;
+    unsigned char *olddata = _csbuf + offs;
+    unsigned char *data = olddata;
+    res = ccnl_ndntlv_dehead(&data, &reslen, &type, &len);
+    assert((res == 0) && (type == NDN_TLV_Data));
+
+    struct ccnl_pkt_s *pkt = ccnl_ndntlv_bytes2pkt(type, olddata, &data, &reslen);
+    assert(pkt != NULL);
+    struct ccnl_content_s *c = ccnl_content_new(&pkt);
+    assert(c != NULL);
+    if (ccnl_content_add2cache(relay, c) == NULL){
+        ccnl_content_free(c);
+    }
+}
+
+/* the simulated sensor: answer every traced Interest with Data of the traced
+ * size, carrying the event id so we can match it on reception */
+int replay_on_interest(struct ccnl_relay_s *relay, struct ccnl_face_s *from,
+                       struct ccnl_pkt_s *pkt)
+{
+    (void)from;
+    char name[NDN_TRACE_NAMELEN + 1];
+
+    _prefix_to_uri(pkt->pfx, name, sizeof(name));
+
+    mutex_lock(&_lock);
+    int id = _find_pending(name);
+    size_t len = (id >= 0) ? _evts[id].arg : 0;
+    mutex_unlock(&_lock);
+
+    if (id < 0) {
+        return 0;
+    }
+
+    uint16_t tmp = (uint16_t)id;
+    memset(_content, 0, len);
+    memcpy(_content, &tmp, sizeof(tmp));
+    _cs_insert(relay, pkt->pfx, _content, len);
+
+    return 0;
+}
+
+static void _on_content(const uint8_t *data, size_t len)
+{
+    uint32_t now = xtimer_now_usec();
+    uint16_t id;
+
+    if (len < sizeof(id)) {
+        return;
+    }
+    memcpy(&id, data, sizeof(id));
+
+    mutex_lock(&_lock);
+    if (id < _numof) {
+        /* CCN-lite's PIT aggregates Interests for the same name, so a single
+         * Data satisfies all pending Interests of that name. It might also
+         * have been served from the CS for a later one, so match by name */
+        int pending = _find_pending(_evts[id].name);
+        if (pending >= 0) {
+            _last_rx = now;
+            _rx_bytes += len;
+        }
+        while (pending >= 0) {
+            _evts[pending].state = EVT_DONE;
+            _evts[pending].latency = now - _evts[pending].sent;
+            pending = _find_pending(_evts[id].name);
+        }
+    }
+    mutex_unlock(&_lock);
+}
+
+static void *_on_data(void *arg)
+{
+    (void)arg;
+    msg_t msg;
+
+    msg_init_queue(_mq, MQSIZE);
+
+    while (1) {
+        msg_receive(&msg);
+
+        if (msg.type == GNRC_NETAPI_MSG_TYPE_RCV) {
+            gnrc_pktsnip_t *snip = msg.content.ptr;
+            assert(snip);
+            if (snip->type == GNRC_NETTYPE_CCN_CHUNK) {
+                _on_content(snip->data, snip->size);
+            }
+            gnrc_pktbuf_release(snip);
+        }
+    }
+
+    /* never reached */
+    return NULL;
+}
+
+static int _send_interest(const char *name)
+{
+    struct ccnl_prefix_s *prefix;
+    int res;
+    char tmp[NDN_TRACE_NAMELEN + 1];
+    memcpy(tmp, name, strlen(name) + 1);
+
+    memset(_scratchpad, 0, sizeof(_scratchpad));
+    prefix = ccnl_URItoPrefix(tmp, CCNL_SUITE_NDNTLV, NULL);
+    if (prefix == NULL) {
+        return -1;
+    }
+    res = ccnl_send_interest(prefix, _scratchpad, sizeof(_scratchpad), NULL);
+    ccnl_prefix_free(prefix);
+
+    return (res >= 0) ? 0 : -1;
+}
+
+static int _cmp_u32(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+/* prepare all events for a new run */
+static void _reset(void)
+{
+    for (unsigned i = 0; i < _numof; i++) {
+        _evts[i].state = EVT_IDLE;
+        if (_evts[i].type != NDN_TRACE_INT_TX) {
+            continue;
+        }
+        /* use the size of the Data that answered this Interest in the trace */
+        _evts[i].arg = DATA_LEN_MIN;
+        for (unsigned j = i + 1; j < _numof; j++) {
+            if ((_evts[j].type == NDN_TRACE_DATA_RX) &&
+                (strcmp(_evts[i].name, _evts[j].name) == 0)) {
+                uint16_t len = _evts[j].arg;
+                if (len > DATA_LEN_MAX) {
+                    len = DATA_LEN_MAX;
+                }
+                if (len > DATA_LEN_MIN) {
+                    _evts[i].arg = len;
+                }
+                break;
+            }
+        }
+    }
+    _rx_bytes = 0;
+}
+
+static void _report(unsigned speed, uint32_t start)
+{
+    unsigned sent = 0;
+    unsigned rx = 0;
+    uint64_t sum = 0;
+
+    mutex_lock(&_lock);
+    for (unsigned i = 0; i < _numof; i++) {
+        if (_evts[i].type != NDN_TRACE_INT_TX) {
+            continue;
+        }
+        sent++;
+        if (_evts[i].state == EVT_DONE) {
+            _lat[rx++] = _evts[i].latency;
+            sum += _evts[i].latency;
+        }
+    }
+    uint32_t duration = (rx) ? (_last_rx - start) : 0;
+    uint32_t bytes = _rx_bytes;
+    mutex_unlock(&_lock);
+
+    qsort(_lat, rx, sizeof(_lat[0]), _cmp_u32);
+    uint32_t min = (rx) ? _lat[0] : 0;
+    uint32_t max = (rx) ? _lat[rx - 1] : 0;
+    uint32_t avg = (rx) ? (uint32_t)(sum / rx) : 0;
+    uint32_t p50 = (rx) ? _lat[(rx * 50) / 100] : 0;
+    uint32_t p95 = (rx) ? _lat[(rx * 95) / 100] : 0;
+    uint32_t pps = (duration) ? (uint32_t)(((uint64_t)rx * US_PER_SEC) / duration) : 0;
+    uint32_t bps = (duration) ? (uint32_t)(((uint64_t)bytes * US_PER_SEC) / duration) : 0;
+
+    printf("replay: %u interests, speed %ux, took %lums\n", sent, speed,
+           (unsigned long)(duration / US_PER_MS));
+    printf("        rx %u, lost %u\n", rx, (sent - rx));
+    printf("        latency [us]: min %lu avg %lu p50 %lu p95 %lu max %lu\n",
+           (unsigned long)min, (unsigned long)avg, (unsigned long)p50,
+           (unsigned long)p95, (unsigned long)max);
+    printf("        throughput: %lu data/s, %lu byte/s\n",
+           (unsigned long)pps, (unsigned long)bps);
+    printf("RESULT sent=%u rx=%u lost=%u min=%lu avg=%lu p50=%lu p95=%lu "
+           "max=%lu pps=%lu bps=%lu\n", sent, rx, (sent - rx),
+           (unsigned long)min, (unsigned long)avg, (unsigned long)p50,
+           (unsigned long)p95, (unsigned long)max,
+           (unsigned long)pps, (unsigned long)bps);
+}
+
+static void _run(unsigned speed)
+{
+    mutex_lock(&_lock);
+    _reset();
+    mutex_unlock(&_lock);
+
+    uint32_t start = xtimer_now_usec();
+    _last_rx = start;
+
+    for (unsigned i = 0; i < _numof; i++) {
+        if (_evts[i].type != NDN_TRACE_INT_TX) {
+            continue;
+        }
+
+        /* wait for the (scaled) time of the event */
+        if (speed > 0) {
+            uint32_t now = xtimer_now_usec();
+            uint32_t due = _evts[i].time / speed;
+            if ((now - start) < due) {
+                xtimer_usleep(due - (now - start));
+            }
+        }
+
+        mutex_lock(&_lock);
+        _evts[i].state = EVT_PENDING;
+        _evts[i].sent = xtimer_now_usec();
+        mutex_unlock(&_lock);
+        if (_send_interest(_evts[i].name) != 0) {
+            printf("replay: unable to send interest for %s\n", _evts[i].name);
+        }
+    }
+
+    /* wait for outstanding Data */
+    uint32_t last = xtimer_now_usec();
+    while ((xtimer_now_usec() - last) < TIMEOUT) {
+        mutex_lock(&_lock);
+        int pending = 0;
+        for (unsigned i = 0; i < _numof; i++) {
+            pending |= (_evts[i].state == EVT_PENDING);
+        }
+        mutex_unlock(&_lock);
+        if (!pending) {
+            break;
+        }
+        xtimer_usleep(POLL_ITVL);
+    }
+
+    _report(speed, start);
+}
+
+static int _add(int argc, char **argv)
+{
+    /* the name is empty if omitted */
+    if (argc < 5) {
+        printf("usage: %s add <time> <type> <arg> [<name>]\n", argv[0]);
+        return 1;
+    }
+    if (_numof >= EVENTS_MAX) {
+        puts("err: replay buffer full");
+        return 1;
+    }
+
+    ndn_trace_type_t type = ndn_trace_type_from_str(argv[3]);
+    if (type == NDN_TRACE_NUMOF) {
+        printf("err: unknown record type '%s'\n", argv[3]);
+        return 1;
+    }
+
+    event_t *evt = &_evts[_numof];
+    memset(evt, 0, sizeof(*evt));
+    evt->time = (uint32_t)strtoul(argv[2], NULL, 10);
+    evt->type = (uint8_t)type;
+    evt->arg = (uint16_t)atoi(argv[4]);
+    if (argc > 5) {
+        strncpy(evt->name, argv[5], NDN_TRACE_NAMELEN);
+        ndn_trace_unescape(evt->name);
+    }
+    _numof++;
+
+    return 0;
+}
+
+int replay_cmd(int argc, char **argv)
+{
+    if (argc < 2) {
+        printf("replay: %u of %u events loaded\n", _numof, EVENTS_MAX);
+        return 0;
+    }
+
+    if (strcmp(argv[1], "add") == 0) {
+        return _add(argc, argv);
+    }
+    else if (strcmp(argv[1], "clear") == 0) {
+        _numof = 0;
+    }
+    else if (strcmp(argv[1], "run") == 0) {
+        unsigned speed = (argc > 2) ? (unsigned)atoi(argv[2]) : 1;
+        _run(speed);
+        if ((argc > 3) && (strcmp(argv[3], "exit") == 0)) {
+            pm_off();
+        }
+    }
+    else {
+        printf("usage: %s [add|clear|run [<speed> [exit]]]\n", argv[0]);
+        return 1;
+    }
+
+    return 0;
+}
+
+void replay_init(void)
+{
+    /* open a thread to handle incoming NDN traffic */
+    kernel_pid_t pid = thread_create(_stack, sizeof(_stack), PRIO, 0,
+                                     _on_data, NULL, "ndn-data-handler");
+    assert(pid > 0);
+
+    /* register data handler to receive all NDN traffic */
+    gnrc_netreg_entry_init_pid(&_reg, GNRC_NETREG_DEMUX_CTX_ALL, pid);
+    int res = gnrc_netreg_register(GNRC_NETTYPE_CCN_CHUNK, &_reg);
+    assert(res == 0);
+    (void)res;
+
+    /* we play the sensor that answers all traced Interests */
+    ccnl_set_local_producer(replay_on_interest);
+}
@@ -0,0 +1,16 @@
+
+
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include "ccn-lite-riot.h"
+
+void replay_init(void);
+
+int replay_on_interest(struct ccnl_relay_s *relay, struct ccnl_face_s *from,
+                       struct ccnl_pkt_s *pkt);
+
+int replay_cmd(int argc, char **argv);
+
+
+#endif /* REPLAY_H */
@@ -0,0 +1,18 @@
+
+#ifndef APP_H
+#define APP_H
+
+#include "ccn-lite-riot.h"
+
+void app_cs_add(struct ccnl_relay_s *relay, unsigned char *data, size_t len,
+                int persist);
+
+void app_hrs_init(void);
+
+void app_hrs_on_interest(struct ccnl_relay_s *relay,
+                         struct ccnl_prefix_s *prefix);
+
+int app_hrs_cmd(int argc, char **argv);
+
+
+#endif /* APP_H */
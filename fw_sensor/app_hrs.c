@@ -0,0 +1,340 @@
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "app.h"
+#include "fmt.h"
+#include "mutex.h"
+#include "random.h"
+#include "thread.h"
+#include "thread_flags.h"
+#include "xtimer.h"
+#include "assert.h"
+#include "ndn_tap.h"
+#include "ndn_idx.h"
+#include "ndn_merkle.h"
+
+#ifdef BOARD_CK12
+#include "board.h"
+#define VIB_DURATION            (50U)
+#endif
+
+/* stay below CCN-lite's thread: the worker signs and encodes without holding
+ * the lock, so CCN-lite's thread only ever waits for a chunk or a signed batch
+ * being published */
+#define PRIO                    (THREAD_PRIORITY_MAIN + 1)
+#define STACKSIZE               (THREAD_STACKSIZE_DEFAULT)
+#define FLAG_DEMAND             (0x0001)
+
+#define HRS_URI_BASE            "/icn19/watch/hrs/"
+#define HRS_URI_MAXLEN          (32U)
+#define CHUNK_MAXLEN            (9U)        /* decimal digits */
+
+/* chunks prepared ahead of demand, and how many of them are moved into the
+ * content store per Interest (besides the requested one) */
+#define READY_NUMOF             (NDN_MERKLE_LEAVES)
+#define READY_DATALEN           (160U)
+#define INSERT_AHEAD            (2U)
+
+typedef struct {
+    uint32_t chunk;
+    size_t offs;                /* encoded Data starts at buf[offs] */
+    unsigned char buf[READY_DATALEN];
+} ready_t;
+
+/* heart rate samples of a batch and their signature */
+typedef struct {
+    ndn_merkle_batch_t batch;
+    uint16_t samples[NDN_MERKLE_LEAVES];
+    int valid;
+} signer_t;
+
+static char _stack[STACKSIZE];
+static thread_t *_worker;
+static mutex_t _lock = MUTEX_INIT;
+
+/* ring buffer of encoded chunks, filled by the worker. The slot behind the
+ * last ready chunk belongs to the worker until it is published by
+ * incrementing _ready_cnt, all fields below are protected by _lock */
+static ready_t _ready[READY_NUMOF];
+static unsigned _ready_head = 0;
+static unsigned _ready_cnt = 0;
+static uint32_t _next_chunk = 0;
+static unsigned _restarts = 0;  /* invalidates chunks in preparation */
+
+/* the last signed batch, shared by both threads so every batch is sampled
+ * and signed only once. Only the worker signs: it fills the spare entry
+ * without holding the lock and publishes it by switching _signed under the
+ * lock, CCN-lite's thread only reads the published batch under the lock */
+static signer_t _signers[2];
+static signer_t *_signed = &_signers[0];
+
+/* used by CCN-lite's thread when the requested chunk is not ready */
+static ready_t _direct;
+
+static struct {
+    uint32_t prepared;
+    uint32_t ahead;             /* Interests for chunks prepared ahead */
+    uint32_t miss;              /* chunks encoded in CCN-lite's thread */
+    uint32_t deferred;          /* Interests left pending for the worker */
+    uint32_t stale;             /* prepared chunks nobody asked for */
+    uint32_t t_max;
+    uint64_t t_sum;
+} _stats;
+
+/* parse the chunk number from the last name component */
+static int _hrs_chunk(const struct ccnl_prefix_s *prefix, uint32_t *chunk)
+{
+    const unsigned char *comp = prefix->comp[prefix->compcnt - 1];
+    size_t len = prefix->complen[prefix->compcnt - 1];
+
+    if ((len == 0) || (len > CHUNK_MAXLEN)) {
+        return -1;
+    }
+    *chunk = 0;
+    for (size_t i = 0; i < len; i++) {
+        if ((comp[i] < '0') || (comp[i] > '9')) {
+            return -1;
+        }
+        *chunk = (*chunk * 10) + (comp[i] - '0');
+    }
+    return 0;
+}
+
+static size_t _hrs_uri(uint32_t chunk, char *uri)
+{
+    size_t pos = strlen(HRS_URI_BASE);
+    memcpy(uri, HRS_URI_BASE, pos);
+    pos += fmt_u32_dec(&uri[pos], chunk);
+    uri[pos] = '\0';
+    return pos;
+}
+
+/* take the samples of a complete batch at once and sign them with a single
+ * tag, instead of signing every 2 byte sample on its own */
+static void _hrs_sign_batch(signer_t *s, uint32_t batch)
+{
+    ndn_merkle_batch_start(&s->batch, batch);
+    for (unsigned i = 0; i < NDN_MERKLE_LEAVES; i++) {
+        s->samples[i] = (uint16_t)random_uint32_range(80, 120);
+        ndn_merkle_batch_add(&s->batch, &s->samples[i], sizeof(uint16_t));
+    }
+    ndn_merkle_batch_sign(&s->batch);
+    s->valid = 1;
+}
+
+static int _is_signed(const signer_t *s, uint32_t chunk)
+{
+    return (s->valid && (s->batch.batch == (chunk / NDN_MERKLE_LEAVES)));
+}
+
+/* encode the Data packet of the given chunk from its signed batch into the
+ * given slot, this only copies the chunk's proof and hashes nothing */
+static int _hrs_encode(const signer_t *s, uint32_t chunk, ready_t *slot)
+{
+    uint8_t content[sizeof(uint16_t) + NDN_MERKLE_TRAILER_LEN];
+    char uri[HRS_URI_MAXLEN];
+    unsigned leaf = (chunk % NDN_MERKLE_LEAVES);
+    size_t reslen = 0;
+
+    assert(_is_signed(s, chunk));
+
+    /* the sample followed by its inclusion proof and the batch's tag */
+    memcpy(content, &s->samples[leaf], sizeof(uint16_t));
+    size_t len = sizeof(uint16_t) +
+                 ndn_merkle_trailer(&s->batch, leaf, &content[sizeof(uint16_t)]);
+
+    _hrs_uri(chunk, uri);
+    struct ccnl_prefix_s *prefix = ccnl_URItoPrefix(uri, CCNL_SUITE_NDNTLV, NULL);
+    if (prefix == NULL) {
+        return -1;
+    }
+    slot->chunk = chunk;
+    slot->offs = sizeof(slot->buf);
+    int res = ccnl_ndntlv_prependContent(prefix, content, len, NULL, NULL,
+                                         &slot->offs, slot->buf, &reslen);
+    ccnl_prefix_free(prefix);
+
+    return (res == 0) ? 0 : -1;
+}
+
+static void _cs_add(struct ccnl_relay_s *relay, ready_t *slot)
+{
+    app_cs_add(relay, &slot->buf[slot->offs], (sizeof(slot->buf) - slot->offs),
+               0);
+}
+
+static int _in_cs(uint32_t chunk)
+{
+    char uri[HRS_URI_MAXLEN];
+    uint8_t name[HRS_URI_MAXLEN];
+
+    _hrs_uri(chunk, uri);
+    int len = ndn_tap_uri_to_name(uri, name, sizeof(name));
+    return ((len > 0) && (ndn_idx_cs_get(name, (size_t)len) != NULL));
+}
+
+static void *_worker_loop(void *arg)
+{
+    (void)arg;
+
+    while (1) {
+        thread_flags_wait_any(FLAG_DEMAND);
+
+#ifdef BOARD_CK12
+        board_vibrate(VIB_DURATION);
+#endif
+
+        while (1) {
+            /* claim the free slot behind the last ready chunk */
+            mutex_lock(&_lock);
+            if (_ready_cnt >= READY_NUMOF) {
+                mutex_unlock(&_lock);
+                break;
+            }
+            ready_t *slot = &_ready[(_ready_head + _ready_cnt) % READY_NUMOF];
+            uint32_t chunk = _next_chunk;
+            unsigned restarts = _restarts;
+            mutex_unlock(&_lock);
+
+            /* sign the chunk's batch into the spare entry, CCN-lite's thread
+             * only sees it once it is published. _signed is only changed by
+             * this thread, so we can read it without the lock */
+            if (!_is_signed(_signed, chunk)) {
+                signer_t *spare = (_signed == &_signers[0]) ? &_signers[1]
+                                                            : &_signers[0];
+                _hrs_sign_batch(spare, (chunk / NDN_MERKLE_LEAVES));
+                mutex_lock(&_lock);
+                _signed = spare;
+                mutex_unlock(&_lock);
+            }
+
+            /* CCN-lite's thread only reads ready chunks and the published
+             * batch, so we can encode into the claimed slot without the lock */
+            if (_hrs_encode(_signed, chunk, slot) != 0) {
+                puts("[sensor] unable to encode chunk");
+                break;
+            }
+
+            /* publish the chunk, unless the consumer jumped meanwhile and
+             * CCN-lite's thread restarted production at another chunk */
+            mutex_lock(&_lock);
+            if (restarts == _restarts) {
+                _next_chunk = chunk + 1;
+                _ready_cnt++;
+                _stats.prepared++;
+            }
+            mutex_unlock(&_lock);
+        }
+    }
+
+    /* never reached */
+    return NULL;
+}
+
+void app_hrs_init(void)
+{
+    kernel_pid_t pid = thread_create(_stack, sizeof(_stack), PRIO, 0,
+                                     _worker_loop, NULL, "hrs-producer");
+    assert(pid > 0);
+    _worker = (thread_t *)thread_get(pid);
+}
+
+void app_hrs_on_interest(struct ccnl_relay_s *relay,
+                         struct ccnl_prefix_s *prefix)
+{
+    uint32_t start = xtimer_now_usec();
+    uint32_t chunk;
+
+    if (_hrs_chunk(prefix, &chunk) != 0) {
+        puts("[sensor] invalid chunk number, ignoring interest");
+        return;
+    }
+
+    mutex_lock(&_lock);
+
+    /* move the requested and the next few prepared chunks into the CS */
+    while (_ready_cnt > 0) {
+        ready_t *slot = &_ready[_ready_head];
+        if (slot->chunk > (chunk + INSERT_AHEAD)) {
+            break;
+        }
+        if (slot->chunk < chunk) {
+            _stats.stale++;
+        }
+        else {
+            _cs_add(relay, slot);
+        }
+        _ready_head = ((_ready_head + 1) % READY_NUMOF);
+        _ready_cnt--;
+    }
+
+    if (_in_cs(chunk)) {
+        _stats.ahead++;
+    }
+    else if (_is_signed(_signed, chunk)) {
+        /* the consumer started or jumped within the signed batch: serve this
+         * chunk right away and let the worker continue behind it */
+        _stats.miss++;
+        if (_hrs_encode(_signed, chunk, &_direct) == 0) {
+            _cs_add(relay, &_direct);
+        }
+        _stats.stale += _ready_cnt;
+        _ready_cnt = 0;
+        _next_chunk = chunk + 1;
+        _restarts++;
+    }
+    else {
+        /* signing a batch takes too long for CCN-lite's thread: restart the
+         * worker at this chunk, unless it is already heading there. The
+         * Interest stays in the PIT and its retransmission finds the chunk
+         * prepared */
+        _stats.deferred++;
+        if ((_ready_cnt > 0) || (_next_chunk != chunk)) {
+            _stats.stale += _ready_cnt;
+            _ready_cnt = 0;
+            _next_chunk = chunk;
+            _restarts++;
+        }
+    }
+
+    uint32_t t = xtimer_now_usec() - start;
+    _stats.t_sum += t;
+    if (t > _stats.t_max) {
+        _stats.t_max = t;
+    }
+    mutex_unlock(&_lock);
+
+    thread_flags_set(_worker, FLAG_DEMAND);
+}
+
+int app_hrs_cmd(int argc, char **argv)
+{
+    if ((argc > 1) && (strcmp(argv[1], "reset") == 0)) {
+        mutex_lock(&_lock);
+        memset(&_stats, 0, sizeof(_stats));
+        mutex_unlock(&_lock);
+        return 0;
+    }
+    else if (argc > 1) {
+        printf("usage: %s [reset]\n", argv[0]);
+        return 1;
+    }
+
+    mutex_lock(&_lock);
+    uint32_t interests = _stats.ahead + _stats.miss + _stats.deferred;
+    printf("hrs: %lu interests, %lu served ahead, %lu encoded on demand, "
+           "%lu deferred\n",
+           (unsigned long)interests, (unsigned long)_stats.ahead,
+           (unsigned long)_stats.miss, (unsigned long)_stats.deferred);
+    printf("     %lu chunks prepared, %lu stale, %u ready (next %lu)\n",
+           (unsigned long)_stats.prepared, (unsigned long)_stats.stale,
+           _ready_cnt, (unsigned long)_next_chunk);
+    printf("     time in forwarder: avg %luus, max %luus\n",
+           (unsigned long)((interests) ? (_stats.t_sum / interests) : 0),
+           (unsigned long)_stats.t_max);
+    mutex_unlock(&_lock);
+
+    return 0;
+}
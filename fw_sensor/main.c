@@ -26,15 +26,17 @@
 #include "msg.h"
 #include "shell.h"
 #include "assert.h"
-#include "random.h"
 #include "ccn-lite-riot.h"
 #include "net/gnrc/netif.h"
 #include "net/gnrc/pktdump.h"
+#include "nimble_autoconn.h"
+#include "nimble_autoconn_params.h"
 
-#ifdef BOARD_CK12
-#include "board.h"
-#define VIB_DURATION        (50U)
-#endif
+#include "energy.h"
+#include "ndn_idx.h"
+#include "ndn_merkle.h"
+
+#include "app.h"
 
 #define NAME_HRS            { "icn19", "watch", "hrs" }
 #define NAME_HRS_COMPCNT    (4U)
@@ -50,28 +52,28 @@ static unsigned char _csbuf[CCNL_MAX_PACKET_SIZE];
 static char _hello[32] = "/hello";
 static char _foo[32] = "/foo";
 
-static void _cs_insert(struct ccnl_relay_s *relay, struct ccnl_prefix_s *prefix,
-                       void *payload, size_t payload_len, int persist)
+static const shell_command_t _cmds[] = {
+    { "energy", "print radio and CPU energy statistics", energy_cmd },
+    { "idxbench", "benchmark hashed against linear name lookups", ndn_idx_bench_cmd },
+    { "merklebench", "benchmark batch signatures against per-packet HMAC", ndn_merkle_bench_cmd },
+    { "hrs", "show statistics of the heart rate producer", app_hrs_cmd },
+    { NULL, NULL, NULL }
+};
+
+void app_cs_add(struct ccnl_relay_s *relay, unsigned char *data, size_t len,
+                int persist)
 {
     int res;
     (void)res;  /* in case we build without develhelp */
 
-    /* generate a NDN-TLV item */
-    size_t offs = sizeof(_csbuf);
-    size_t reslen = 0;
-    res = ccnl_ndntlv_prependContent(prefix, payload, payload_len,
-                                     NULL, NULL, &offs, _csbuf, &reslen);
-    assert(res == 0);
-
     /* do strange CCN-lite things to add the content into the content store */
-    size_t len;
+    size_t tlen;
     uint64_t type;
-    unsigned char *olddata = _csbuf + offs;
-    unsigned char *data = olddata;
-    res = ccnl_ndntlv_dehead(&data, &reslen, &type, &len);
+    unsigned char *olddata = data;
+    res = ccnl_ndntlv_dehead(&data, &len, &type, &tlen);
     assert((res == 0) && (type == NDN_TLV_Data));
 
-    struct ccnl_pkt_s *pkt = ccnl_ndntlv_bytes2pkt(type, olddata, &data, &reslen);
+    struct ccnl_pkt_s *pkt = ccnl_ndntlv_bytes2pkt(type, olddata, &data, &len);
     assert(pkt != NULL);
     struct ccnl_content_s *c = ccnl_content_new(&pkt);
     assert(c != NULL);
@@ -83,11 +85,20 @@ static void _cs_insert(struct ccnl_relay_s *relay, struct ccnl_prefix_s *prefix,
     }
 }
 
-static void _heartbeat_into_cs(struct ccnl_relay_s *relay,
-                               struct ccnl_prefix_s *prefix)
+static void _cs_insert(struct ccnl_relay_s *relay, struct ccnl_prefix_s *prefix,
+                       void *payload, size_t payload_len, int persist)
 {
-    uint16_t bpm = (uint16_t)random_uint32_range(80, 120);
-    _cs_insert(relay, prefix, &bpm, 2, 0);
+    int res;
+    (void)res;  /* in case we build without develhelp */
+
+    /* generate a NDN-TLV item */
+    size_t offs = sizeof(_csbuf);
+    size_t reslen = 0;
+    res = ccnl_ndntlv_prependContent(prefix, payload, payload_len,
+                                     NULL, NULL, &offs, _csbuf, &reslen);
+    assert(res == 0);
+
+    app_cs_add(relay, _csbuf + offs, reslen, persist);
 }
 
 static void _insert_static_content(char *name, const char *data)
@@ -111,10 +122,9 @@ static int _on_interest(struct ccnl_relay_s *relay,
         memcmp(p->comp[1], _name_hrs[1], p->complen[1]) == 0 &&
         memcmp(p->comp[2], _name_hrs[2], p->complen[2]) == 0) {
         puts("[sensor] got interest for /icn19/watch/hrs/x");
-#ifdef BOARD_CK12
-        board_vibrate(VIB_DURATION);
-#endif
-        _heartbeat_into_cs(relay, p);
+        /* chunks are prepared by the producer thread, we only make sure the
+         * requested one is in the content store */
+        app_hrs_on_interest(relay, p);
     }
     /* dirty hack to 'keep' /foo and /bar in the content store */
     else if (p->compcnt == 1 &&
@@ -136,6 +146,12 @@ int main(void)
     puts("NDN-BLE-Demo: Sensor Node");
 
     msg_init_queue(_main_msg_queue, MAIN_QUEUE_SIZE);
+
+    /* track energy spent on connections and on producing data */
+    energy_init();
+    nimble_autoconn_eventcb(energy_on_netif_evt);
+    energy_autoconn(&nimble_autoconn_params);
+
     ccnl_core_init();
     ccnl_start();
 
@@ -145,11 +161,12 @@ int main(void)
     res = ccnl_open_netif(netif->pid, GNRC_NETTYPE_CCN);
     assert(res >= 0);
 
-    /* we produce new heart-rate data on-the-fly */
+    /* we produce new heart-rate data ahead of the consumer's requests */
+    app_hrs_init();
     ccnl_set_local_producer(_on_interest);
 
     /* run the shell (for debugging purposes) */
     char line_buf[SHELL_DEFAULT_BUFSIZE];
-    shell_run(NULL, line_buf, SHELL_DEFAULT_BUFSIZE);
+    shell_run(_cmds, line_buf, SHELL_DEFAULT_BUFSIZE);
     return 0;
 }
@@ -0,0 +1,440 @@
+/*
+ * Copyright (C) 2019 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     energy
+ * @{
+ *
+ * @file
+ * @brief       Energy accounting implementation
+ *
+ * @author      Hauke Petersen <hauke.petersen@fu-berlin.de>
+ *
+ * @}
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "irq.h"
+#include "assert.h"
+#include "sched.h"
+#include "thread.h"
+#include "fmt.h"
+#include "xtimer.h"
+#include "ndn_tap.h"
+
+#include "energy.h"
+
+#ifdef MODULE_NIMBLE_HOST
+#include "host/ble_gap.h"
+#endif
+#ifdef MODULE_NIMBLE_NETIF
+#include "nimble_netif_conn.h"
+#endif
+
+/* BLE link parameters used to derive the airtime of a packet */
+#define LL_PAYLOAD_MAX          (27U)       /* no data length extension */
+#define LL_PDU_OVERHEAD         (10U)       /* preamble, AA, header, CRC */
+#define L2CAP_OVERHEAD          (6U)        /* L2CAP header and SDU length */
+#define US_PER_BYTE             (8U)        /* 1Mbit PHY */
+
+typedef struct {
+    uint32_t pkts[2];
+    uint32_t bytes[2];
+    uint64_t tx_us;
+    uint64_t rx_us;
+    uint64_t cpu_us;
+} cls_stats_t;
+
+typedef struct {
+    uint32_t itvl;
+    uint64_t start;
+} conn_t;
+
+static energy_model_t _model = ENERGY_MODEL_DEFAULT;
+static ndn_tap_t _tap;
+
+static uint64_t _t_reset;
+static cls_stats_t _cls[NDN_TAP_CLS_NUMOF];
+static conn_t _conn[ENERGY_CONN_NUMOF];
+static uint64_t _conn_evts;
+static int _phase_active[ENERGY_PHASE_NUMOF];
+static uint64_t _phase_start[ENERGY_PHASE_NUMOF];
+static uint64_t _phase_us[ENERGY_PHASE_NUMOF];
+/* share of a phase's active time actually spent in it, in per mille */
+static uint32_t _phase_pm[ENERGY_PHASE_NUMOF] = { 1000, 1000, 1000 };
+static int _autoconn = 0;
+
+static kernel_pid_t _idle_pid = KERNEL_PID_UNDEF;
+static uint64_t _sched_base_total;
+static uint64_t _sched_base_idle;
+
+static const char *_phase_str[] = { "scan", "adv", "gatt-adv" };
+
+static const struct {
+    const char *name;
+    size_t offset;
+} _model_params[] = {
+    { "voltage_mv", offsetof(energy_model_t, voltage_mv) },
+    { "i_tx", offsetof(energy_model_t, i_tx) },
+    { "i_rx", offsetof(energy_model_t, i_rx) },
+    { "i_cpu", offsetof(energy_model_t, i_cpu) },
+    { "i_sleep", offsetof(energy_model_t, i_sleep) },
+    { "evt_tx_us", offsetof(energy_model_t, evt_tx_us) },
+    { "evt_rx_us", offsetof(energy_model_t, evt_rx_us) },
+    { "scan_rx_pm", offsetof(energy_model_t, scan_rx_pm) },
+    { "adv_tx_pm", offsetof(energy_model_t, adv_tx_pm) },
+    { "adv_rx_pm", offsetof(energy_model_t, adv_rx_pm) },
+};
+
+static uint32_t *_model_param(unsigned i)
+{
+    return (uint32_t *)((uint8_t *)&_model + _model_params[i].offset);
+}
+
+/* energy in uJ for the given current [uA] and time [us] */
+static uint64_t _uj(uint32_t current, uint64_t us)
+{
+    /* split the product to not overflow after a few days of runtime */
+    uint64_t uas = (uint64_t)current * us;
+    return ((uas / 1000000000ULL) * _model.voltage_mv) +
+           (((uas % 1000000000ULL) * _model.voltage_mv) / 1000000000ULL);
+}
+
+static void _sched_read(uint64_t *total, uint64_t *idle)
+{
+    *total = 0;
+    *idle = 0;
+    for (kernel_pid_t pid = KERNEL_PID_FIRST; pid <= KERNEL_PID_LAST; pid++) {
+        *total += sched_pidlist[pid].runtime_ticks;
+    }
+    if (_idle_pid != KERNEL_PID_UNDEF) {
+        *idle = sched_pidlist[_idle_pid].runtime_ticks;
+    }
+}
+
+static void _on_pkt(const ndn_tap_evt_t *evt, void *arg)
+{
+    (void)arg;
+
+    /* derive the airtime of the packet from its size on the BLE link */
+    size_t len = evt->len + L2CAP_OVERHEAD;
+    unsigned frags = (len + LL_PAYLOAD_MAX - 1) / LL_PAYLOAD_MAX;
+    uint32_t data_us = (len + (frags * LL_PDU_OVERHEAD)) * US_PER_BYTE;
+    uint32_t ack_us = frags * LL_PDU_OVERHEAD * US_PER_BYTE;
+
+    unsigned state = irq_disable();
+    cls_stats_t *cls = &_cls[evt->cls];
+    cls->pkts[evt->dir]++;
+    cls->bytes[evt->dir] += evt->len;
+    cls->cpu_us += evt->cpu_us;
+    if (evt->dir == NDN_TAP_TX) {
+        cls->tx_us += data_us;
+        cls->rx_us += ack_us;
+    }
+    else {
+        cls->rx_us += data_us;
+        cls->tx_us += ack_us;
+    }
+    irq_restore(state);
+}
+
+/* fold the time of all ongoing phases and connections into the counters */
+static void _fold(uint64_t now)
+{
+    for (unsigned i = 0; i < ENERGY_PHASE_NUMOF; i++) {
+        if (_phase_active[i]) {
+            _phase_us[i] += ((now - _phase_start[i]) * _phase_pm[i]) / 1000;
+            _phase_start[i] = now;
+        }
+    }
+    for (unsigned i = 0; i < ENERGY_CONN_NUMOF; i++) {
+        if (_conn[i].itvl) {
+            uint64_t evts = (now - _conn[i].start) / _conn[i].itvl;
+            _conn_evts += evts;
+            _conn[i].start += (evts * _conn[i].itvl);
+        }
+    }
+}
+
+void energy_init(void)
+{
+    for (kernel_pid_t pid = KERNEL_PID_FIRST; pid <= KERNEL_PID_LAST; pid++) {
+        thread_t *t = (thread_t *)thread_get(pid);
+        if (t && (t->priority == THREAD_PRIORITY_IDLE)) {
+            _idle_pid = pid;
+            break;
+        }
+    }
+
+    energy_reset();
+
+    _tap.cb = _on_pkt;
+    _tap.arg = NULL;
+    ndn_tap_register(&_tap);
+}
+
+void energy_reset(void)
+{
+    unsigned state = irq_disable();
+    uint64_t now = xtimer_now_usec64();
+    _fold(now);
+    _t_reset = now;
+    memset(_cls, 0, sizeof(_cls));
+    memset(_phase_us, 0, sizeof(_phase_us));
+    _conn_evts = 0;
+    _sched_read(&_sched_base_total, &_sched_base_idle);
+    irq_restore(state);
+}
+
+void energy_phase(energy_phase_t phase, int active)
+{
+    unsigned state = irq_disable();
+    uint64_t now = xtimer_now_usec64();
+    if (active && !_phase_active[phase]) {
+        _phase_start[phase] = now;
+    }
+    else if (!active && _phase_active[phase]) {
+        _phase_us[phase] += ((now - _phase_start[phase]) * _phase_pm[phase])
+                            / 1000;
+    }
+    _phase_active[phase] = active;
+    irq_restore(state);
+}
+
+void energy_conn(unsigned slot, uint32_t itvl_us)
+{
+    assert(slot < ENERGY_CONN_NUMOF);
+
+    unsigned state = irq_disable();
+    uint64_t now = xtimer_now_usec64();
+    /* account the events of the previous interval setting first */
+    if (_conn[slot].itvl) {
+        _conn_evts += (now - _conn[slot].start) / _conn[slot].itvl;
+    }
+    _conn[slot].itvl = itvl_us;
+    _conn[slot].start = now;
+    irq_restore(state);
+}
+
+#ifdef MODULE_NIMBLE_HOST
+void energy_conn_gap(unsigned slot, uint16_t gaphandle)
+{
+    struct ble_gap_conn_desc desc;
+    if (ble_gap_conn_find(gaphandle, &desc) != 0) {
+        return;
+    }
+    /* the connection interval is given in units of 1.25ms */
+    energy_conn(slot, ((uint32_t)desc.conn_itvl * 1250));
+}
+#endif
+
+#ifdef MODULE_NIMBLE_AUTOCONN
+void energy_autoconn(const nimble_autoconn_params_t *params)
+{
+    uint32_t period = params->period_scan + params->period_adv;
+
+    unsigned state = irq_disable();
+    _fold(xtimer_now_usec64());
+    if (period > 0) {
+        _phase_pm[ENERGY_PHASE_SCAN] = (params->period_scan * 1000) / period;
+        _phase_pm[ENERGY_PHASE_ADV] = 1000 - _phase_pm[ENERGY_PHASE_SCAN];
+    }
+    _autoconn = 1;
+    irq_restore(state);
+
+    /* no connection is open yet, so autoconn is looking for neighbors */
+    energy_phase(ENERGY_PHASE_SCAN, 1);
+    energy_phase(ENERGY_PHASE_ADV, 1);
+}
+#endif
+
+#ifdef MODULE_NIMBLE_NETIF
+/* autoconn discovers neighbors only while a netif connection slot is free */
+static void _autoconn_update(void)
+{
+    unsigned open = 0;
+
+    if (!_autoconn) {
+        return;
+    }
+    for (unsigned i = 0; i < NIMBLE_NETIF_MAX_CONN; i++) {
+        open += (_conn[i].itvl != 0);
+    }
+    int discover = (open < NIMBLE_NETIF_MAX_CONN);
+    energy_phase(ENERGY_PHASE_SCAN, discover);
+    energy_phase(ENERGY_PHASE_ADV, discover);
+}
+
+void energy_on_netif_evt(int handle, nimble_netif_event_t event)
+{
+    if ((handle < 0) || ((unsigned)handle >= NIMBLE_NETIF_MAX_CONN) ||
+        ((unsigned)handle >= ENERGY_CONN_NUMOF)) {
+        return;
+    }
+
+    switch (event) {
+        case NIMBLE_NETIF_CONNECTED_MASTER:
+        case NIMBLE_NETIF_CONNECTED_SLAVE:
+        case NIMBLE_NETIF_CONN_UPDATED: {
+            nimble_netif_conn_t *conn = nimble_netif_conn_get(handle);
+            if (conn) {
+                energy_conn_gap((unsigned)handle, conn->gaphandle);
+            }
+            break;
+        }
+        case NIMBLE_NETIF_CLOSED_MASTER:
+        case NIMBLE_NETIF_CLOSED_SLAVE:
+            energy_conn((unsigned)handle, 0);
+            break;
+        default:
+            break;
+    }
+    _autoconn_update();
+}
+#endif
+
+static const char *_u64_str(char *buf, uint64_t val)
+{
+    buf[fmt_u64_dec(buf, val)] = '\0';
+    return buf;
+}
+
+static void _print_row(const char *name, uint64_t us, uint64_t uj)
+{
+    char buf[2][21];
+    printf("%10s %12s %12s\n", name, _u64_str(buf[0], us / 1000),
+           _u64_str(buf[1], uj));
+}
+
+static void _print_stats(void)
+{
+    cls_stats_t cls[NDN_TAP_CLS_NUMOF];
+    uint64_t phase_us[ENERGY_PHASE_NUMOF];
+    uint64_t conn_evts, total, idle;
+
+    /* take a consistent snapshot of all counters */
+    unsigned state = irq_disable();
+    uint64_t now = xtimer_now_usec64();
+    _fold(now);
+    memcpy(cls, _cls, sizeof(cls));
+    memcpy(phase_us, _phase_us, sizeof(phase_us));
+    conn_evts = _conn_evts;
+    _sched_read(&total, &idle);
+    irq_restore(state);
+
+    uint64_t elapsed = now - _t_reset;
+    total -= _sched_base_total;
+    idle -= _sched_base_idle;
+    uint64_t cpu_us = (total) ? (elapsed * (total - idle)) / total : 0;
+    uint64_t sleep_us = elapsed - cpu_us;
+
+    uint64_t pkt_tx = 0;
+    uint64_t pkt_rx = 0;
+    for (unsigned i = 0; i < NDN_TAP_CLS_NUMOF; i++) {
+        pkt_tx += cls[i].tx_us;
+        pkt_rx += cls[i].rx_us;
+    }
+    uint64_t evt_tx = conn_evts * _model.evt_tx_us;
+    uint64_t evt_rx = conn_evts * _model.evt_rx_us;
+    uint64_t scan_rx = (phase_us[ENERGY_PHASE_SCAN] * _model.scan_rx_pm) / 1000;
+    uint64_t adv_us = phase_us[ENERGY_PHASE_ADV] +
+                      phase_us[ENERGY_PHASE_GATT_ADV];
+    uint64_t adv_tx = (adv_us * _model.adv_tx_pm) / 1000;
+    uint64_t adv_rx = (adv_us * _model.adv_rx_pm) / 1000;
+
+    uint64_t e_pkt_tx = _uj(_model.i_tx, pkt_tx);
+    uint64_t e_pkt_rx = _uj(_model.i_rx, pkt_rx);
+    uint64_t e_conn = _uj(_model.i_tx, evt_tx) + _uj(_model.i_rx, evt_rx);
+    uint64_t e_scan = _uj(_model.i_rx, scan_rx);
+    uint64_t e_adv = _uj(_model.i_tx, adv_tx) + _uj(_model.i_rx, adv_rx);
+    uint64_t e_cpu = _uj(_model.i_cpu, cpu_us);
+    uint64_t e_sleep = _uj(_model.i_sleep, sleep_us);
+    char buf[21];
+
+    printf("energy: tracked for %lums, %lu connection events\n",
+           (unsigned long)(elapsed / 1000), (unsigned long)conn_evts);
+    for (unsigned i = 0; i < ENERGY_PHASE_NUMOF; i++) {
+        printf("        %lums in %s phase\n",
+               (unsigned long)(phase_us[i] / 1000), _phase_str[i]);
+    }
+    printf("%10s %12s %12s\n", "state", "radio [ms]", "energy [uJ]");
+    _print_row("pkt-tx", pkt_tx, e_pkt_tx);
+    _print_row("pkt-rx", pkt_rx, e_pkt_rx);
+    _print_row("conn-evt", (evt_tx + evt_rx), e_conn);
+    _print_row("scan", scan_rx, e_scan);
+    _print_row("adv", (adv_tx + adv_rx), e_adv);
+    _print_row("cpu", cpu_us, e_cpu);
+    _print_row("sleep", sleep_us, e_sleep);
+    printf("%10s %12s %12s\n", "total", "",
+           _u64_str(buf, (e_pkt_tx + e_pkt_rx + e_conn + e_scan + e_adv +
+                          e_cpu + e_sleep)));
+
+    printf("\n%10s %8s %8s %8s %8s %10s %10s %12s\n", "class", "rx-pkt",
+           "rx-byte", "tx-pkt", "tx-byte", "air [us]", "cpu [us]",
+           "energy [uJ]");
+    for (unsigned i = 0; i < NDN_TAP_CLS_NUMOF; i++) {
+        uint64_t e = _uj(_model.i_tx, cls[i].tx_us) +
+                     _uj(_model.i_rx, cls[i].rx_us) +
+                     _uj(_model.i_cpu, cls[i].cpu_us);
+        printf("%10s %8lu %8lu %8lu %8lu %10lu %10lu %12s\n",
+               ndn_tap_cls_str(i),
+               (unsigned long)cls[i].pkts[NDN_TAP_RX],
+               (unsigned long)cls[i].bytes[NDN_TAP_RX],
+               (unsigned long)cls[i].pkts[NDN_TAP_TX],
+               (unsigned long)cls[i].bytes[NDN_TAP_TX],
+               (unsigned long)(cls[i].tx_us + cls[i].rx_us),
+               (unsigned long)cls[i].cpu_us, _u64_str(buf, e));
+    }
+}
+
+static int _cmd_model(int argc, char **argv)
+{
+    unsigned numof = sizeof(_model_params) / sizeof(_model_params[0]);
+
+    if (argc < 4) {
+        for (unsigned i = 0; i < numof; i++) {
+            printf("%12s: %lu\n", _model_params[i].name,
+                   (unsigned long)*_model_param(i));
+        }
+        return 0;
+    }
+
+    for (unsigned i = 0; i < numof; i++) {
+        if (strcmp(argv[2], _model_params[i].name) == 0) {
+            *_model_param(i) = (uint32_t)strtoul(argv[3], NULL, 10);
+            return 0;
+        }
+    }
+
+    printf("err: unknown model parameter '%s'\n", argv[2]);
+    return 1;
+}
+
+int energy_cmd(int argc, char **argv)
+{
+    if (argc < 2) {
+        _print_stats();
+        return 0;
+    }
+
+    if (strcmp(argv[1], "reset") == 0) {
+        energy_reset();
+        puts("energy: counters reset");
+        return 0;
+    }
+    if (strcmp(argv[1], "model") == 0) {
+        return _cmd_model(argc, argv);
+    }
+
+    printf("usage: %s [reset|model [<param> <value>]]\n", argv[0]);
+    return 1;
+}
@@ -0,0 +1,194 @@
+/*
+ * Copyright (C) 2019 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @defgroup    energy Radio and CPU energy accounting
+ * @brief       Estimate the energy a node spends on BLE and NDN traffic
+ *
+ * We can not measure the current drawn by a node from within the firmware, so
+ * this module tracks the time a node spends in its different radio and CPU
+ * states and estimates the consumed energy from a simple, configurable power
+ * model:
+ *
+ * - radio TX/RX airtime of every NDN packet, derived from its size on the BLE
+ *   link (LL fragmentation and acknowledgments included), attributed to the
+ *   Interest and Data traffic classes
+ * - empty connection events needed to keep BLE connections alive
+ * - time spent scanning and advertising, weighted with a radio duty cycle
+ * - CPU active time (everything not spent in the idle thread), of which the
+ *   time CCN-lite spends on received packets is attributed to the traffic
+ *   classes
+ *
+ * The results are printed using the `energy` shell command.
+ *
+ * @{
+ *
+ * @file
+ * @brief       Energy accounting interface
+ *
+ * @author      Hauke Petersen <hauke.petersen@fu-berlin.de>
+ */
+
+#ifndef ENERGY_H
+#define ENERGY_H
+
+#include <stdint.h>
+
+#ifdef MODULE_NIMBLE_NETIF
+#include "nimble_netif.h"
+#endif
+#ifdef MODULE_NIMBLE_AUTOCONN
+#include "nimble_autoconn.h"
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief   Number of BLE connections we can track in parallel
+ */
+#ifndef ENERGY_CONN_NUMOF
+#define ENERGY_CONN_NUMOF       (4U)
+#endif
+
+/**
+ * @brief   Radio phases that are accounted by time instead of by packet
+ */
+typedef enum {
+    ENERGY_PHASE_SCAN,          /**< node is scanning */
+    ENERGY_PHASE_ADV,           /**< node is advertising (autoconn) */
+    ENERGY_PHASE_GATT_ADV,      /**< node is advertising its GATT services */
+    ENERGY_PHASE_NUMOF,         /**< number of phases */
+} energy_phase_t;
+
+/**
+ * @brief   Power model parameters
+ *
+ * All currents are given in uA, the duty cycles in per mille of the time spent
+ * in the corresponding phase.
+ */
+typedef struct {
+    uint32_t voltage_mv;        /**< supply voltage [mV] */
+    uint32_t i_tx;              /**< radio TX current [uA] */
+    uint32_t i_rx;              /**< radio RX current [uA] */
+    uint32_t i_cpu;             /**< CPU active current [uA] */
+    uint32_t i_sleep;           /**< system sleep current [uA] */
+    uint32_t evt_tx_us;         /**< radio TX time of an empty conn event */
+    uint32_t evt_rx_us;         /**< radio RX time of an empty conn event */
+    uint32_t scan_rx_pm;        /**< radio RX duty cycle while scanning */
+    uint32_t adv_tx_pm;         /**< radio TX duty cycle while advertising */
+    uint32_t adv_rx_pm;         /**< radio RX duty cycle while advertising */
+} energy_model_t;
+
+/**
+ * @brief   Default power model, values roughly match a nRF52832 at 0dBm
+ */
+#ifndef ENERGY_MODEL_DEFAULT
+#define ENERGY_MODEL_DEFAULT    { .voltage_mv = 3000,       \
+                                  .i_tx = 7100,             \
+                                  .i_rx = 6500,             \
+                                  .i_cpu = 3700,            \
+                                  .i_sleep = 2,             \
+                                  .evt_tx_us = 220,         \
+                                  .evt_rx_us = 220,         \
+                                  .scan_rx_pm = 500,        \
+                                  .adv_tx_pm = 14,          \
+                                  .adv_rx_pm = 6 }
+#endif
+
+/**
+ * @brief   Initialize energy accounting and start tracking
+ *
+ * @note    Must be called before CCN-lite is started.
+ */
+void energy_init(void);
+
+/**
+ * @brief   Reset all counters
+ */
+void energy_reset(void);
+
+/**
+ * @brief   Mark the start or end of a radio phase
+ *
+ * @param[in] phase     phase to switch
+ * @param[in] active    true when the phase is entered, false when left
+ */
+void energy_phase(energy_phase_t phase, int active);
+
+/**
+ * @brief   Track a BLE connection
+ *
+ * Slots below NIMBLE_NETIF_MAX_CONN are used by energy_on_netif_evt(), other
+ * connections (e.g. GATT) use the slots above.
+ *
+ * @param[in] slot      connection slot, 0 to ENERGY_CONN_NUMOF - 1
+ * @param[in] itvl_us   connection interval [us], 0 when the connection closed
+ */
+void energy_conn(unsigned slot, uint32_t itvl_us);
+
+/**
+ * @brief   Track a BLE connection using its NimBLE GAP handle
+ *
+ * This is a convenience wrapper around energy_conn() that reads the connection
+ * interval from the NimBLE host.
+ *
+ * @param[in] slot      connection slot, 0 to ENERGY_CONN_NUMOF - 1
+ * @param[in] gaphandle GAP connection handle
+ */
+void energy_conn_gap(unsigned slot, uint16_t gaphandle);
+
+#if defined(MODULE_NIMBLE_AUTOCONN) || defined(DOXYGEN)
+/**
+ * @brief   Let energy_on_netif_evt() track the scan and advertising phases of
+ *          nimble_autoconn
+ *
+ * Autoconn alternates between scanning and advertising as long as there is a
+ * free netif connection slot and stops both once all slots are in use. Other
+ * connections and ENERGY_PHASE_GATT_ADV do not affect this. The time a
+ * free slot is available is split between the scan and advertising phases
+ * according to autoconn's scan and advertising periods.
+ *
+ * @param[in] params    parameters autoconn was started with
+ */
+void energy_autoconn(const nimble_autoconn_params_t *params);
+#endif
+
+#if defined(MODULE_NIMBLE_NETIF) || defined(DOXYGEN)
+/**
+ * @brief   Event callback for nimble_netif connections
+ *
+ * Applications call this from their nimble_netif (or autoconn) event callback,
+ * the netif connection handle is used as connection slot. After
+ * energy_autoconn() was called, the scan and advertising phases are switched
+ * based on the number of open connections as well.
+ *
+ * @param[in] handle    nimble_netif connection handle
+ * @param[in] event     connection event
+ */
+void energy_on_netif_evt(int handle, nimble_netif_event_t event);
+#endif
+
+/**
+ * @brief   Shell command for printing the statistics and configuring the
+ *          power model
+ *
+ * @param[in] argc      number of arguments
+ * @param[in] argv      arguments
+ *
+ * @return  0 on success, 1 on error
+ */
+int energy_cmd(int argc, char **argv);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ENERGY_H */
+/** @} */
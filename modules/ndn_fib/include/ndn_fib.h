@@ -0,0 +1,268 @@
+/*
+ * Copyright (C) 2019 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @defgroup    ndn_fib Static route management
+ * @brief       Install, inspect and age static NDN routes
+ *
+ * This module keeps a table of static routes in a trie with one node per name
+ * component, where a longest prefix match costs one walk down the trie,
+ * independent of the number of routes. Interests CCN-lite forwards are looked
+ * up in this trie (by wrapping ccnl_interest_propagate()) and sent to the next
+ * hop of the longest matching route. Only Interests without a matching route
+ * are handed on to CCN-lite, which floods them (RONR). Installed routes thus
+ * take precedence over flooding.
+ *
+ * All routes are mirrored into CCN-lite's FIB as well, a linked list compared
+ * against the name entry by entry. CCN-lite retransmits pending Interests from
+ * within its own code, where the call can not be wrapped, so retransmissions
+ * still use that list. The trie also counts the received Interests matching
+ * each route (using @ref ndn_tap), which includes Interests that are then
+ * answered from the content store. `fibbench` compares both lookups.
+ *
+ * CCN-lite's FIB may only be changed from CCN-lite's thread, so route changes
+ * are applied from CCN-lite's ageing timer (once per second). Routes can be
+ * given a lifetime, expired routes are removed from both tables the same way.
+ *
+ * @{
+ *
+ * @file
+ * @brief       Component trie FIB interface
+ *
+ * @author      Hauke Petersen <hauke.petersen@fu-berlin.de>
+ */
+
+#ifndef NDN_FIB_H
+#define NDN_FIB_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief   Maximum number of routes
+ */
+#ifndef NDN_FIB_ROUTES
+#define NDN_FIB_ROUTES          (8U)
+#endif
+
+/**
+ * @brief   Number of trie nodes (one per distinct prefix component)
+ */
+#ifndef NDN_FIB_NODES
+#define NDN_FIB_NODES           (32U)
+#endif
+
+/**
+ * @brief   Maximum length of a single name component in bytes
+ */
+#ifndef NDN_FIB_COMPLEN
+#define NDN_FIB_COMPLEN         (16U)
+#endif
+
+/**
+ * @brief   Maximum number of components of a route's prefix
+ */
+#ifndef NDN_FIB_DEPTH
+#define NDN_FIB_DEPTH           (8U)
+#endif
+
+/**
+ * @brief   Maximum length of a link layer address
+ */
+#ifndef NDN_FIB_ADDRLEN
+#define NDN_FIB_ADDRLEN         (8U)
+#endif
+
+/**
+ * @brief   Time to wait for CCN-lite's thread to apply a route change [us]
+ */
+#ifndef NDN_FIB_REQ_TIMEOUT
+#define NDN_FIB_REQ_TIMEOUT     (3U * 1000U * 1000U)
+#endif
+
+/**
+ * @brief   Marks the end of a node list
+ */
+#define NDN_FIB_NIL             (UINT16_MAX)
+
+/**
+ * @brief   Trie node, representing a single name component
+ */
+typedef struct {
+    void *val;                      /**< value stored for this prefix or NULL */
+    uint16_t child;                 /**< first child node */
+    uint16_t sibling;               /**< next sibling, next free node if unused */
+    uint8_t len;                    /**< length of the component */
+    uint8_t comp[NDN_FIB_COMPLEN];  /**< component value */
+} ndn_fib_node_t;
+
+/**
+ * @brief   Component trie
+ */
+typedef struct {
+    ndn_fib_node_t *nodes;          /**< nodes, nodes[0] is the empty prefix */
+    uint16_t numof;                 /**< number of nodes */
+    uint16_t free;                  /**< list of unused nodes */
+} ndn_fib_trie_t;
+
+/**
+ * @brief   Callback for iterating the values of a trie
+ *
+ * @param[in] name      TLV encoded name the value is stored for
+ * @param[in] len       length of @p name in bytes
+ * @param[in] val       stored value
+ * @param[in] arg       user argument
+ */
+typedef void (*ndn_fib_walk_cb_t)(const uint8_t *name, size_t len,
+                                  void *val, void *arg);
+
+/**
+ * @brief   Initialize a trie
+ *
+ * @param[out] trie     trie to initialize
+ * @param[in] nodes     memory for the trie's nodes
+ * @param[in] numof     number of nodes, at least 1
+ */
+void ndn_fib_trie_init(ndn_fib_trie_t *trie, ndn_fib_node_t *nodes,
+                       uint16_t numof);
+
+/**
+ * @brief   Store a value for the given prefix, replacing any previous value
+ *
+ * @param[in,out] trie  trie
+ * @param[in] name      TLV encoded name prefix
+ * @param[in] len       length of @p name in bytes
+ * @param[in] val       value to store, must not be NULL
+ *
+ * @return  0 on success
+ * @return  -1 if the name is invalid or the trie is out of nodes
+ */
+int ndn_fib_trie_put(ndn_fib_trie_t *trie, const uint8_t *name, size_t len,
+                     void *val);
+
+/**
+ * @brief   Remove the value stored for the given prefix
+ *
+ * @param[in,out] trie  trie
+ * @param[in] name      TLV encoded name prefix
+ * @param[in] len       length of @p name in bytes
+ *
+ * @return  the removed value
+ * @return  NULL if no value was stored for @p name
+ */
+void *ndn_fib_trie_del(ndn_fib_trie_t *trie, const uint8_t *name, size_t len);
+
+/**
+ * @brief   Get the value stored for exactly the given prefix
+ *
+ * @param[in] trie      trie
+ * @param[in] name      TLV encoded name prefix
+ * @param[in] len       length of @p name in bytes
+ *
+ * @return  stored value
+ * @return  NULL if no value is stored for @p name
+ */
+void *ndn_fib_trie_get(const ndn_fib_trie_t *trie, const uint8_t *name,
+                       size_t len);
+
+/**
+ * @brief   Get the value stored for the longest prefix of the given name
+ *
+ * @param[in] trie      trie
+ * @param[in] name      TLV encoded name
+ * @param[in] len       length of @p name in bytes
+ *
+ * @return  value of the longest matching prefix
+ * @return  NULL if no stored prefix matches @p name
+ */
+void *ndn_fib_trie_lpm(const ndn_fib_trie_t *trie, const uint8_t *name,
+                       size_t len);
+
+/**
+ * @brief   Call @p cb for every value stored in the trie
+ *
+ * @param[in] trie      trie
+ * @param[in] cb        callback
+ * @param[in] arg       user argument passed to @p cb
+ */
+void ndn_fib_trie_walk(const ndn_fib_trie_t *trie, ndn_fib_walk_cb_t cb,
+                       void *arg);
+
+/**
+ * @brief   Initialize the FIB
+ *
+ * @note    Must be called before CCN-lite is started.
+ */
+void ndn_fib_init(void);
+
+/**
+ * @brief   Add a route or update an existing one
+ *
+ * Blocks until CCN-lite's thread applied the change, which takes up to a
+ * second, or until NDN_FIB_REQ_TIMEOUT passed.
+ *
+ * @note    Must not be called from CCN-lite's thread.
+ *
+ * @param[in] prefix    name prefix as URI
+ * @param[in] addr      link layer address of the next hop
+ * @param[in] addr_len  length of @p addr in bytes
+ * @param[in] lifetime  lifetime of the route in seconds, 0 for permanent
+ *
+ * @return  0 on success
+ * @return  -1 if the prefix is invalid, the FIB is full or CCN-lite is not
+ *          running
+ */
+int ndn_fib_add(const char *prefix, const uint8_t *addr, size_t addr_len,
+                uint32_t lifetime);
+
+/**
+ * @brief   Remove a route
+ *
+ * Blocks until CCN-lite's thread applied the change, which takes up to a
+ * second, or until NDN_FIB_REQ_TIMEOUT passed.
+ *
+ * @note    Must not be called from CCN-lite's thread.
+ *
+ * @param[in] prefix    name prefix as URI
+ *
+ * @return  0 on success
+ * @return  -1 if there is no route for @p prefix
+ */
+int ndn_fib_del(const char *prefix);
+
+/**
+ * @brief   Shell command for adding, removing and listing routes
+ *
+ * @param[in] argc      number of arguments
+ * @param[in] argv      arguments
+ *
+ * @return  0 on success, 1 on error
+ */
+int ndn_fib_cmd(int argc, char **argv);
+
+/**
+ * @brief   Shell command benchmarking trie against linear FIB lookups for a
+ *          range of route counts
+ *
+ * @param[in] argc      number of arguments
+ * @param[in] argv      arguments
+ *
+ * @return  0 on success, 1 on error
+ */
+int ndn_fib_bench_cmd(int argc, char **argv);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* NDN_FIB_H */
+/** @} */
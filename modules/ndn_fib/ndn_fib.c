@@ -0,0 +1,708 @@
+/*
+ * Copyright (C) 2019 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     ndn_fib
+ * @{
+ *
+ * @file
+ * @brief       Component trie FIB implementation
+ *
+ * @author      Hauke Petersen <hauke.petersen@fu-berlin.de>
+ *
+ * @}
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "assert.h"
+#include "mutex.h"
+#include "xtimer.h"
+#include "byteorder.h"
+#include "net/ethertype.h"
+#include "net/gnrc/netif.h"
+#include "ndn_tap.h"
+
+#include "ndn_fib.h"
+
+#define TLV_COMPONENT           (0x08)
+
+/* TLV encoded and URI representation of the longest possible route prefix */
+#define NAMELEN                 (NDN_FIB_DEPTH * (2 + NDN_FIB_COMPLEN))
+#define URILEN                  ((NDN_FIB_DEPTH * (1 + NDN_FIB_COMPLEN)) + 2)
+
+typedef struct {
+    struct ccnl_face_s *face;       /* next hop's face in CCN-lite */
+    uint32_t matched;               /* received Interests matching the route */
+    uint32_t expires;               /* in s since boot, 0 for permanent */
+    uint8_t addr[NDN_FIB_ADDRLEN];
+    uint8_t addr_len;               /* 0 if the route is unused */
+} route_t;
+
+typedef struct {
+    uint32_t now;
+    route_t *route;
+    uint8_t name[NAMELEN];
+    size_t len;
+} expired_t;
+
+/* a copy of the n-th route in the trie, taken for printing it */
+typedef struct {
+    unsigned skip;
+    int found;
+    route_t route;
+    uint8_t name[NAMELEN];
+    size_t len;
+} snapshot_t;
+
+/* a route change, handed over to CCN-lite's thread */
+typedef struct {
+    int add;
+    uint8_t name[NAMELEN];
+    size_t len;
+    const uint8_t *addr;
+    size_t addr_len;
+    uint32_t lifetime;
+    int res;
+} req_t;
+
+static ndn_fib_node_t _nodes[NDN_FIB_NODES];
+static ndn_fib_trie_t _fib;
+static route_t _routes[NDN_FIB_ROUTES];
+static uint32_t _next_expiry = 0;
+
+static mutex_t _lock = MUTEX_INIT;
+static ndn_tap_t _tap;
+
+/* CCN-lite's FIB must only be touched from CCN-lite's thread, so route changes
+ * are applied from its ageing timer. _req is protected by _lock */
+static req_t *_req = NULL;
+static mutex_t _req_serial = MUTEX_INIT;
+static mutex_t _req_done = MUTEX_INIT_LOCKED;
+
+/* the original CCN-lite functions, resolved by the linker (--wrap) */
+void __real_ccnl_do_ageing(void *ptr, void *dummy);
+void __real_ccnl_interest_propagate(struct ccnl_relay_s *ccnl,
+                                    struct ccnl_interest_s *i);
+
+static int _next_comp(const uint8_t **pos, const uint8_t *end,
+                      const uint8_t **comp, size_t *len)
+{
+    uint32_t type, tlen;
+
+    if ((ndn_tap_tlv(pos, end, &type, &tlen) != 0) || (type != TLV_COMPONENT)) {
+        return -1;
+    }
+    *comp = *pos;
+    *len = tlen;
+    *pos += tlen;
+    return 0;
+}
+
+static uint16_t _child(const ndn_fib_trie_t *trie, uint16_t parent,
+                       const uint8_t *comp, size_t len)
+{
+    for (uint16_t n = trie->nodes[parent].child; n != NDN_FIB_NIL;
+         n = trie->nodes[n].sibling) {
+        const ndn_fib_node_t *node = &trie->nodes[n];
+        if ((node->len == len) && (memcmp(node->comp, comp, len) == 0)) {
+            return n;
+        }
+    }
+    return NDN_FIB_NIL;
+}
+
+/* follow the given name down the trie, path[i] is the node of the first i
+ * components */
+static int _path(const ndn_fib_trie_t *trie, const uint8_t *name, size_t len,
+                 uint16_t *path, unsigned *depth)
+{
+    const uint8_t *pos = name;
+    const uint8_t *end = name + len;
+
+    path[0] = 0;
+    *depth = 0;
+    while (pos < end) {
+        const uint8_t *comp;
+        size_t clen;
+        if ((*depth >= NDN_FIB_DEPTH) ||
+            (_next_comp(&pos, end, &comp, &clen) != 0)) {
+            return -1;
+        }
+        uint16_t n = _child(trie, path[*depth], comp, clen);
+        if (n == NDN_FIB_NIL) {
+            return -1;
+        }
+        path[++(*depth)] = n;
+    }
+    return 0;
+}
+
+/* release nodes along the given path that hold neither a value nor any
+ * children, starting with the deepest one */
+static void _prune(ndn_fib_trie_t *trie, const uint16_t *path, unsigned depth)
+{
+    while (depth > 0) {
+        uint16_t n = path[depth];
+        ndn_fib_node_t *node = &trie->nodes[n];
+        if ((node->val != NULL) || (node->child != NDN_FIB_NIL)) {
+            break;
+        }
+
+        uint16_t *link = &trie->nodes[path[depth - 1]].child;
+        while (*link != n) {
+            link = &trie->nodes[*link].sibling;
+        }
+        *link = node->sibling;
+        node->sibling = trie->free;
+        trie->free = n;
+        depth--;
+    }
+}
+
+void ndn_fib_trie_init(ndn_fib_trie_t *trie, ndn_fib_node_t *nodes,
+                       uint16_t numof)
+{
+    assert((numof > 0) && (numof < NDN_FIB_NIL));
+
+    memset(nodes, 0, (numof * sizeof(ndn_fib_node_t)));
+    trie->nodes = nodes;
+    trie->numof = numof;
+    trie->free = NDN_FIB_NIL;
+    nodes[0].child = NDN_FIB_NIL;
+    nodes[0].sibling = NDN_FIB_NIL;
+    for (uint16_t i = (numof - 1); i > 0; i--) {
+        nodes[i].sibling = trie->free;
+        trie->free = i;
+    }
+}
+
+int ndn_fib_trie_put(ndn_fib_trie_t *trie, const uint8_t *name, size_t len,
+                     void *val)
+{
+    const uint8_t *pos = name;
+    const uint8_t *end = name + len;
+    uint16_t path[NDN_FIB_DEPTH + 1];
+    unsigned depth = 0;
+
+    assert(val != NULL);
+
+    path[0] = 0;
+    while (pos < end) {
+        const uint8_t *comp;
+        size_t clen;
+        if ((depth >= NDN_FIB_DEPTH) ||
+            (_next_comp(&pos, end, &comp, &clen) != 0) ||
+            (clen > NDN_FIB_COMPLEN)) {
+            /* drop nodes we might have allocated for this name already */
+            _prune(trie, path, depth);
+            return -1;
+        }
+
+        uint16_t n = _child(trie, path[depth], comp, clen);
+        if (n == NDN_FIB_NIL) {
+            if (trie->free == NDN_FIB_NIL) {
+                _prune(trie, path, depth);
+                return -1;
+            }
+            n = trie->free;
+            ndn_fib_node_t *node = &trie->nodes[n];
+            trie->free = node->sibling;
+            node->val = NULL;
+            node->child = NDN_FIB_NIL;
+            node->len = (uint8_t)clen;
+            memcpy(node->comp, comp, clen);
+            node->sibling = trie->nodes[path[depth]].child;
+            trie->nodes[path[depth]].child = n;
+        }
+        path[++depth] = n;
+    }
+    trie->nodes[path[depth]].val = val;
+
+    return 0;
+}
+
+void *ndn_fib_trie_del(ndn_fib_trie_t *trie, const uint8_t *name, size_t len)
+{
+    uint16_t path[NDN_FIB_DEPTH + 1];
+    unsigned depth;
+
+    if (_path(trie, name, len, path, &depth) != 0) {
+        return NULL;
+    }
+    void *val = trie->nodes[path[depth]].val;
+    trie->nodes[path[depth]].val = NULL;
+    _prune(trie, path, depth);
+
+    return val;
+}
+
+void *ndn_fib_trie_get(const ndn_fib_trie_t *trie, const uint8_t *name,
+                       size_t len)
+{
+    uint16_t path[NDN_FIB_DEPTH + 1];
+    unsigned depth;
+
+    if (_path(trie, name, len, path, &depth) != 0) {
+        return NULL;
+    }
+    return trie->nodes[path[depth]].val;
+}
+
+void *ndn_fib_trie_lpm(const ndn_fib_trie_t *trie, const uint8_t *name,
+                       size_t len)
+{
+    const uint8_t *pos = name;
+    const uint8_t *end = name + len;
+    void *res = trie->nodes[0].val;
+    uint16_t n = 0;
+
+    while (pos < end) {
+        const uint8_t *comp;
+        size_t clen;
+        if (_next_comp(&pos, end, &comp, &clen) != 0) {
+            break;
+        }
+        n = _child(trie, n, comp, clen);
+        if (n == NDN_FIB_NIL) {
+            break;
+        }
+        if (trie->nodes[n].val != NULL) {
+            res = trie->nodes[n].val;
+        }
+    }
+
+    return res;
+}
+
+static void _walk(const ndn_fib_trie_t *trie, uint16_t n, uint8_t *name,
+                  size_t len, ndn_fib_walk_cb_t cb, void *arg)
+{
+    if (trie->nodes[n].val != NULL) {
+        cb(name, len, trie->nodes[n].val, arg);
+    }
+    for (uint16_t c = trie->nodes[n].child; c != NDN_FIB_NIL;
+         c = trie->nodes[c].sibling) {
+        const ndn_fib_node_t *node = &trie->nodes[c];
+        name[len] = TLV_COMPONENT;
+        name[len + 1] = node->len;
+        memcpy(&name[len + 2], node->comp, node->len);
+        _walk(trie, c, name, (len + 2 + node->len), cb, arg);
+    }
+}
+
+void ndn_fib_trie_walk(const ndn_fib_trie_t *trie, ndn_fib_walk_cb_t cb,
+                       void *arg)
+{
+    uint8_t name[NAMELEN];
+    _walk(trie, 0, name, 0, cb, arg);
+}
+
+static uint32_t _now(void)
+{
+    return (uint32_t)(xtimer_now_usec64() / US_PER_SEC);
+}
+
+static struct ccnl_face_s *_face(const route_t *route)
+{
+    sockunion sun;
+
+    memset(&sun, 0, sizeof(sun));
+    sun.sa.sa_family = AF_PACKET;
+    memcpy(sun.linklayer.sll_addr, route->addr, route->addr_len);
+    sun.linklayer.sll_halen = route->addr_len;
+    sun.linklayer.sll_protocol = htons(ETHERTYPE_NDN);
+    /* the BLE interface is the only one CCN-lite is opened on */
+    struct ccnl_face_s *face = ccnl_get_face_or_create(&ccnl_relay, 0, &sun.sa,
+                                                       sizeof(sun.linklayer));
+    /* keep CCN-lite's ageing from removing the idle face together with all
+     * FIB entries pointing to it */
+    if (face != NULL) {
+        face->flags |= CCNL_FACE_FLAGS_STATIC;
+    }
+    return face;
+}
+
+/* mirror a route into (or remove it from) CCN-lite's FIB */
+static int _ccnl_fib(const uint8_t *name, size_t len, route_t *route,
+                     int add)
+{
+    char uri[URILEN];
+    ndn_tap_pkt_t pkt = { .name = name, .name_len = len };
+    int res = -1;
+
+    if (ndn_tap_name_to_uri(&pkt, uri, sizeof(uri)) == 0) {
+        strcpy(uri, "/");
+    }
+    struct ccnl_prefix_s *pfx = ccnl_URItoPrefix(uri, CCNL_SUITE_NDNTLV, NULL);
+    struct ccnl_face_s *face = _face(route);
+    if ((pfx != NULL) && (face != NULL)) {
+        if (add) {
+            /* CCN-lite's FIB takes ownership of the prefix it is given */
+            struct ccnl_prefix_s *dup = ccnl_prefix_dup(pfx);
+            res = (dup) ? ccnl_fib_add_entry(&ccnl_relay, dup, face) : -1;
+            route->face = face;
+        }
+        else {
+            res = ccnl_fib_rem_entry(&ccnl_relay, pfx, face);
+        }
+    }
+    if (pfx != NULL) {
+        ccnl_prefix_free(pfx);
+    }
+
+    return (res < 0) ? -1 : 0;
+}
+
+static void _remove(const uint8_t *name, size_t len)
+{
+    route_t *route = ndn_fib_trie_del(&_fib, name, len);
+    if (route != NULL) {
+        _ccnl_fib(name, len, route, 0);
+        route->addr_len = 0;
+    }
+}
+
+static void _find_expired(const uint8_t *name, size_t len, void *val, void *arg)
+{
+    expired_t *exp = arg;
+    route_t *route = val;
+
+    if ((exp->route == NULL) && (route->expires != 0) &&
+        ((int32_t)(exp->now - route->expires) >= 0)) {
+        exp->route = route;
+        memcpy(exp->name, name, len);
+        exp->len = len;
+    }
+}
+
+/* drop all expired routes, must be called from CCN-lite's thread with the
+ * lock held */
+static void _expire(void)
+{
+    expired_t exp;
+
+    exp.now = _now();
+    if ((_next_expiry == 0) || ((int32_t)(exp.now - _next_expiry) < 0)) {
+        return;
+    }
+
+    /* the trie must not change while walking it, so remove one at a time */
+    do {
+        exp.route = NULL;
+        ndn_fib_trie_walk(&_fib, _find_expired, &exp);
+        if (exp.route != NULL) {
+            _remove(exp.name, exp.len);
+        }
+    } while (exp.route != NULL);
+
+    _next_expiry = 0;
+    for (unsigned i = 0; i < NDN_FIB_ROUTES; i++) {
+        if ((_routes[i].addr_len != 0) && (_routes[i].expires != 0) &&
+            ((_next_expiry == 0) ||
+             ((int32_t)(_routes[i].expires - _next_expiry) < 0))) {
+            _next_expiry = _routes[i].expires;
+        }
+    }
+}
+
+static void _on_pkt(const ndn_tap_evt_t *evt, void *arg)
+{
+    (void)arg;
+    ndn_tap_pkt_t pkt;
+
+    if ((evt->dir != NDN_TAP_RX) || (evt->cls != NDN_TAP_CLS_INTEREST) ||
+        (ndn_tap_parse(evt->data, evt->len, &pkt) != 0)) {
+        return;
+    }
+
+    mutex_lock(&_lock);
+    _expire();
+    route_t *route = ndn_fib_trie_lpm(&_fib, pkt.name, pkt.name_len);
+    if (route != NULL) {
+        route->matched++;
+    }
+    mutex_unlock(&_lock);
+}
+
+void ndn_fib_init(void)
+{
+    ndn_fib_trie_init(&_fib, _nodes, NDN_FIB_NODES);
+    memset(_routes, 0, sizeof(_routes));
+
+    _tap.cb = _on_pkt;
+    _tap.arg = NULL;
+    ndn_tap_register(&_tap);
+}
+
+/* add or update a route, must be called from CCN-lite's thread with the lock
+ * held */
+static int _add(const uint8_t *name, size_t len, const uint8_t *addr,
+                size_t addr_len, uint32_t lifetime)
+{
+    route_t *route = ndn_fib_trie_get(&_fib, name, len);
+    if (route != NULL) {
+        /* replace the next hop of an existing route */
+        _ccnl_fib(name, len, route, 0);
+    }
+    else {
+        for (unsigned i = 0; i < NDN_FIB_ROUTES; i++) {
+            if (_routes[i].addr_len == 0) {
+                route = &_routes[i];
+                break;
+            }
+        }
+        if ((route == NULL) || (ndn_fib_trie_put(&_fib, name, len, route) != 0)) {
+            return -1;
+        }
+    }
+
+    memcpy(route->addr, addr, addr_len);
+    route->addr_len = (uint8_t)addr_len;
+    route->matched = 0;
+    route->expires = (lifetime) ? (_now() + lifetime) : 0;
+    if ((route->expires != 0) &&
+        ((_next_expiry == 0) ||
+         ((int32_t)(route->expires - _next_expiry) < 0))) {
+        _next_expiry = route->expires;
+    }
+
+    int res = _ccnl_fib(name, len, route, 1);
+    if (res != 0) {
+        ndn_fib_trie_del(&_fib, name, len);
+        route->addr_len = 0;
+    }
+    return res;
+}
+
+void __wrap_ccnl_interest_propagate(struct ccnl_relay_s *ccnl,
+                                    struct ccnl_interest_s *i)
+{
+    ndn_tap_pkt_t pkt;
+    struct ccnl_face_s *face = NULL;
+
+    if ((i == NULL) || (i->pkt == NULL) || (i->pkt->buf == NULL) ||
+        (ndn_tap_parse(i->pkt->buf->data, i->pkt->buf->datalen, &pkt) != 0)) {
+        __real_ccnl_interest_propagate(ccnl, i);
+        return;
+    }
+
+    mutex_lock(&_lock);
+    route_t *route = ndn_fib_trie_lpm(&_fib, pkt.name, pkt.name_len);
+    if (route != NULL) {
+        face = route->face;
+    }
+    mutex_unlock(&_lock);
+
+    if (face == NULL) {
+        /* no route, let CCN-lite flood the Interest */
+        __real_ccnl_interest_propagate(ccnl, i);
+        return;
+    }
+    /* never send an Interest back to where it came from */
+    if ((i->from != face) || (i->from->flags & CCNL_FACE_FLAGS_REFLECT)) {
+        struct ccnl_buf_s *buf = ccnl_buf_new(i->pkt->buf->data,
+                                              i->pkt->buf->datalen);
+        if (buf != NULL) {
+            ccnl_face_enqueue(ccnl, face, buf);
+        }
+    }
+}
+
+void __wrap_ccnl_do_ageing(void *ptr, void *dummy)
+{
+    __real_ccnl_do_ageing(ptr, dummy);
+
+    mutex_lock(&_lock);
+    _expire();
+    if (_req != NULL) {
+        if (_req->add) {
+            _req->res = _add(_req->name, _req->len, _req->addr, _req->addr_len,
+                             _req->lifetime);
+        }
+        else if (ndn_fib_trie_get(&_fib, _req->name, _req->len) != NULL) {
+            _remove(_req->name, _req->len);
+            _req->res = 0;
+        }
+        _req = NULL;
+        mutex_unlock(&_req_done);
+    }
+    mutex_unlock(&_lock);
+}
+
+/* hand a route change to CCN-lite's thread and wait for its result */
+static int _request(req_t *req)
+{
+    req->res = -1;
+
+    mutex_lock(&_req_serial);
+    mutex_lock(&_lock);
+    _req = req;
+    mutex_unlock(&_lock);
+
+    if (xtimer_mutex_lock_timeout(&_req_done, NDN_FIB_REQ_TIMEOUT) != 0) {
+        /* CCN-lite is not running, withdraw the request unless it was
+         * applied in the meantime */
+        mutex_lock(&_lock);
+        if (_req == req) {
+            _req = NULL;
+        }
+        else {
+            mutex_trylock(&_req_done);
+        }
+        mutex_unlock(&_lock);
+    }
+    mutex_unlock(&_req_serial);
+
+    return req->res;
+}
+
+int ndn_fib_add(const char *prefix, const uint8_t *addr, size_t addr_len,
+                uint32_t lifetime)
+{
+    req_t req = { .add = 1, .addr = addr, .addr_len = addr_len,
+                  .lifetime = lifetime };
+    int len = ndn_tap_uri_to_name(prefix, req.name, sizeof(req.name));
+
+    if ((len < 0) || (addr_len == 0) || (addr_len > NDN_FIB_ADDRLEN)) {
+        return -1;
+    }
+    req.len = (size_t)len;
+    return _request(&req);
+}
+
+int ndn_fib_del(const char *prefix)
+{
+    req_t req = { .add = 0 };
+    int len = ndn_tap_uri_to_name(prefix, req.name, sizeof(req.name));
+
+    if (len < 0) {
+        return -1;
+    }
+    req.len = (size_t)len;
+    return _request(&req);
+}
+
+static void _snapshot(const uint8_t *name, size_t len, void *val, void *arg)
+{
+    snapshot_t *snap = arg;
+
+    if (snap->found || (snap->skip-- > 0)) {
+        return;
+    }
+    snap->found = 1;
+    snap->route = *(route_t *)val;
+    memcpy(snap->name, name, len);
+    snap->len = len;
+}
+
+static void _print_route(const uint8_t *name, size_t len, const route_t *route,
+                         uint32_t now)
+{
+    ndn_tap_pkt_t pkt = { .name = name, .name_len = len };
+    char uri[URILEN];
+    char addr[3 * NDN_FIB_ADDRLEN];
+
+    if (ndn_tap_name_to_uri(&pkt, uri, sizeof(uri)) == 0) {
+        strcpy(uri, "/");
+    }
+    gnrc_netif_addr_to_str(route->addr, route->addr_len, addr);
+    printf("%-24s via %s, %lu interests matched", uri, addr,
+           (unsigned long)route->matched);
+    if ((route->expires != 0) && ((int32_t)(now - route->expires) >= 0)) {
+        puts(", expired");
+    }
+    else if (route->expires != 0) {
+        printf(", expires in %lus\n", (unsigned long)(route->expires - now));
+    }
+    else {
+        puts(", permanent");
+    }
+}
+
+static void _print(void)
+{
+    unsigned routes = 0;
+    unsigned nodes = 0;
+
+    mutex_lock(&_lock);
+    nodes = _fib.numof;
+    for (unsigned i = 0; i < NDN_FIB_ROUTES; i++) {
+        routes += (_routes[i].addr_len != 0);
+    }
+    for (uint16_t n = _fib.free; n != NDN_FIB_NIL; n = _nodes[n].sibling) {
+        nodes--;
+    }
+    mutex_unlock(&_lock);
+
+    printf("fib: %u/%u routes, %u/%u trie nodes\n", routes, NDN_FIB_ROUTES,
+           nodes, NDN_FIB_NODES);
+    /* copy one route at a time, so nothing is printed with the lock held */
+    uint32_t now = _now();
+    for (unsigned i = 0; i < NDN_FIB_ROUTES; i++) {
+        snapshot_t snap = { .skip = i };
+        mutex_lock(&_lock);
+        ndn_fib_trie_walk(&_fib, _snapshot, &snap);
+        mutex_unlock(&_lock);
+        if (!snap.found) {
+            break;
+        }
+        _print_route(snap.name, snap.len, &snap.route, now);
+    }
+}
+
+static void _reset_counters(void)
+{
+    mutex_lock(&_lock);
+    for (unsigned i = 0; i < NDN_FIB_ROUTES; i++) {
+        _routes[i].matched = 0;
+    }
+    mutex_unlock(&_lock);
+}
+
+int ndn_fib_cmd(int argc, char **argv)
+{
+    if (argc < 2) {
+        _print();
+        return 0;
+    }
+
+    if (strcmp(argv[1], "reset") == 0) {
+        _reset_counters();
+        return 0;
+    }
+
+    if ((strcmp(argv[1], "add") == 0) && (argc >= 4)) {
+        uint8_t addr[GNRC_NETIF_L2ADDR_MAXLEN];
+        size_t addr_len = gnrc_netif_addr_from_str(argv[3], addr);
+        uint32_t lifetime = (argc > 4) ? (uint32_t)atoi(argv[4]) : 0;
+        if ((addr_len == 0) || (addr_len > NDN_FIB_ADDRLEN)) {
+            printf("err: invalid address '%s'\n", argv[3]);
+            return 1;
+        }
+        if (ndn_fib_add(argv[2], addr, addr_len, lifetime) != 0) {
+            puts("err: unable to add route");
+            return 1;
+        }
+        return 0;
+    }
+
+    if ((strcmp(argv[1], "del") == 0) && (argc >= 3)) {
+        if (ndn_fib_del(argv[2]) != 0) {
+            printf("err: no route for '%s'\n", argv[2]);
+            return 1;
+        }
+        return 0;
+    }
+
+    printf("usage: %s [reset|add <prefix> <addr> [<lifetime s>]|"
+           "del <prefix>]\n", argv[0]);
+    return 1;
+}
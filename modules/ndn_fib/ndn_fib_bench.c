@@ -0,0 +1,170 @@
+/*
+ * Copyright (C) 2019 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     ndn_fib
+ * @{
+ *
+ * @file
+ * @brief       Lookup benchmark: component trie vs. CCN-lite's linear FIB
+ *
+ * @author      Hauke Petersen <hauke.petersen@fu-berlin.de>
+ *
+ * @}
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "fmt.h"
+#include "xtimer.h"
+#include "ndn_tap.h"
+
+#include "ndn_fib.h"
+
+#define BENCH_MAX               (128U)
+#define BENCH_DEFAULT           (64U)
+#define BENCH_ROUNDS            (500U)
+#define BENCH_NAMELEN           (48U)
+#define BENCH_URI_BASE          "/icn19/bench/"
+/* routes are grouped below common prefixes, like routes of one producer */
+#define BENCH_GROUP             (8U)
+#define BENCH_NODES             (BENCH_MAX + (BENCH_MAX / BENCH_GROUP) + 3)
+
+typedef struct route {
+    struct route *next;
+    struct ccnl_prefix_s *pfx;      /* route, as CCN-lite's FIB sees it */
+    struct ccnl_prefix_s *query;    /* Interest name below the route */
+    uint8_t qname[BENCH_NAMELEN];
+    uint8_t qlen;
+} route_t;
+
+static route_t _routes[BENCH_MAX];
+static ndn_fib_node_t _nodes[BENCH_NODES];
+
+static int _setup(unsigned numof, ndn_fib_trie_t *trie)
+{
+    char uri[BENCH_NAMELEN];
+    uint8_t name[BENCH_NAMELEN];
+
+    ndn_fib_trie_init(trie, _nodes, BENCH_NODES);
+    for (unsigned i = 0; i < numof; i++) {
+        route_t *r = &_routes[i];
+        size_t pos = strlen(BENCH_URI_BASE);
+        memcpy(uri, BENCH_URI_BASE, pos);
+        pos += fmt_u32_dec(&uri[pos], (i / BENCH_GROUP));
+        uri[pos++] = '/';
+        pos += fmt_u32_dec(&uri[pos], i);
+        uri[pos] = '\0';
+        int len = ndn_tap_uri_to_name(uri, name, sizeof(name));
+        if ((len < 0) || (ndn_fib_trie_put(trie, name, (size_t)len, r) != 0)) {
+            return -1;
+        }
+        r->pfx = ndn_tap_uri_to_prefix(uri);
+        memcpy(&uri[pos], "/chunk", sizeof("/chunk"));
+        r->qlen = (uint8_t)ndn_tap_uri_to_name(uri, r->qname, sizeof(r->qname));
+        r->query = ndn_tap_uri_to_prefix(uri);
+        r->next = (i > 0) ? &_routes[i - 1] : NULL;
+        if ((r->pfx == NULL) || (r->query == NULL)) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static void _teardown(unsigned numof)
+{
+    for (unsigned i = 0; i < numof; i++) {
+        if (_routes[i].pfx) {
+            ccnl_prefix_free(_routes[i].pfx);
+        }
+        if (_routes[i].query) {
+            ccnl_prefix_free(_routes[i].query);
+        }
+        _routes[i].pfx = NULL;
+        _routes[i].query = NULL;
+    }
+}
+
+/* the lookup target of round r, spread over all routes */
+static route_t *_target(unsigned r, unsigned numof)
+{
+    return &_routes[(r * 7919) % numof];
+}
+
+static void _run(unsigned numof, const ndn_fib_trie_t *trie)
+{
+    route_t *head = &_routes[numof - 1];
+    unsigned found[2] = { 0 };
+    unsigned nodes = trie->numof;
+    uint32_t t[2];
+
+    for (uint16_t n = trie->free; n != NDN_FIB_NIL; n = trie->nodes[n].sibling) {
+        nodes--;
+    }
+
+    /* compare against all routes, like CCN-lite's FIB lookup */
+    t[0] = xtimer_now_usec();
+    for (unsigned r = 0; r < BENCH_ROUNDS; r++) {
+        route_t *q = _target(r, numof);
+        route_t *best = NULL;
+        int best_len = 0;
+        for (route_t *e = head; e; e = e->next) {
+            int res = ccnl_prefix_cmp(e->pfx, NULL, q->query, CMP_LONGEST);
+            if ((res >= (int)e->pfx->compcnt) && (res > best_len)) {
+                best = e;
+                best_len = res;
+            }
+        }
+        found[0] += (best == q);
+    }
+    t[0] = xtimer_now_usec() - t[0];
+
+    t[1] = xtimer_now_usec();
+    for (unsigned r = 0; r < BENCH_ROUNDS; r++) {
+        route_t *q = _target(r, numof);
+        found[1] += (ndn_fib_trie_lpm(trie, q->qname, q->qlen) == q);
+    }
+    t[1] = xtimer_now_usec() - t[1];
+
+    printf("%6u %6u %8u", numof, nodes,
+           (unsigned)(nodes * sizeof(ndn_fib_node_t)));
+    for (unsigned i = 0; i < 2; i++) {
+        /* time per lookup in ns, flag runs that returned wrong routes */
+        printf(" %11lu%c", (unsigned long)(((uint64_t)t[i] * 1000) / BENCH_ROUNDS),
+               (found[i] == BENCH_ROUNDS) ? ' ' : '!');
+    }
+    puts("");
+}
+
+int ndn_fib_bench_cmd(int argc, char **argv)
+{
+    unsigned max = (argc > 1) ? (unsigned)atoi(argv[1]) : BENCH_DEFAULT;
+    ndn_fib_trie_t trie;
+
+    if ((max < 1) || (max > BENCH_MAX)) {
+        printf("usage: %s [<max routes, 1-%u>]\n", argv[0], BENCH_MAX);
+        return 1;
+    }
+
+    printf("lookup time [ns], %u lookups per route count\n", BENCH_ROUNDS);
+    printf("%6s %6s %8s %12s %12s\n", "routes", "nodes", "bytes",
+           "lpm-list", "lpm-trie");
+    for (unsigned numof = 1; numof <= max; numof <<= 1) {
+        if (_setup(numof, &trie) != 0) {
+            puts("err: out of memory");
+            _teardown(numof);
+            return 1;
+        }
+        _run(numof, &trie);
+        _teardown(numof);
+    }
+
+    return 0;
+}
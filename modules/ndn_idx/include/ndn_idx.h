@@ -0,0 +1,214 @@
+/*
+ * Copyright (C) 2019 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @defgroup    ndn_idx Hashed NDN name index
+ * @brief       Constant time exact and longest prefix lookups of NDN names
+ *
+ * CCN-lite keeps its content store and PIT in linked lists and compares
+ * prefixes entry by entry, so lookups get slower with every entry added. This
+ * module provides a hash index for such tables:
+ *
+ * - entries are stored in an open addressing hash table keyed on the hash of
+ *   their full, TLV encoded name
+ * - a side index counts the entries per name length (in components), so a
+ *   longest prefix lookup only probes the prefix lengths that actually exist.
+ *   Hashes of all prefixes of a name are computed in a single pass.
+ *
+ * The index only stores hashes and pointers to the indexed objects. Hash
+ * collisions are resolved using a user supplied match function.
+ *
+ * Additionally, this module maintains an index of CCN-lite's content store by
+ * wrapping ccnl_content_add2cache(), ccnl_content_remove() and
+ * ccnl_content_free(). When the store is full, the least recently used entry
+ * is removed through the wrapped ccnl_content_remove() before a new entry is
+ * added, so CCN-lite does not need to replace one internally. CCN-lite still
+ * ages out entries from within its own code, where calls can not be wrapped,
+ * so the index is rebuilt from the content store whenever the store's entry
+ * count does not match.
+ *
+ * Only the firmware's own content store lookups (ndn_idx_cs_get()) use the
+ * index. CCN-lite's forwarding still matches Interests against its content
+ * store and PIT by walking its lists, and there is no PIT index. The
+ * `idxbench` shell command compares the lookup structures on their own, it
+ * does not measure forwarding.
+ *
+ * @{
+ *
+ * @file
+ * @brief       Hashed NDN name index interface
+ *
+ * @author      Hauke Petersen <hauke.petersen@fu-berlin.de>
+ */
+
+#ifndef NDN_IDX_H
+#define NDN_IDX_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "ccn-lite-riot.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief   Maximum number of name components considered by the index
+ */
+#ifndef NDN_IDX_COMP_MAX
+#define NDN_IDX_COMP_MAX        (16U)
+#endif
+
+/**
+ * @brief   Number of slots of the content store index, must be a power of 2
+ *
+ * Should be at least twice CCNL_CACHE_SIZE. If the content store holds more
+ * entries than fit, lookups fall back to walking the content store.
+ */
+#ifndef NDN_IDX_CS_SLOTS
+#define NDN_IDX_CS_SLOTS        (32U)
+#endif
+
+/**
+ * @brief   Check if the given object has exactly the given name
+ *
+ * @param[in] ptr       indexed object
+ * @param[in] name      TLV encoded name (value of the Name TLV)
+ * @param[in] len       length of @p name in bytes
+ *
+ * @return  non-zero if the name of @p ptr equals @p name
+ */
+typedef int (*ndn_idx_match_t)(const void *ptr,
+                               const uint8_t *name, size_t len);
+
+/**
+ * @brief   Index slot
+ */
+typedef struct {
+    const void *ptr;            /**< indexed object, NULL if slot is empty */
+    uint32_t hash;              /**< hash of the object's name */
+    uint8_t comps;              /**< number of name components */
+} ndn_idx_slot_t;
+
+/**
+ * @brief   Index context
+ */
+typedef struct {
+    ndn_idx_slot_t *slots;      /**< hash table */
+    unsigned mask;              /**< number of slots - 1 */
+    unsigned numof;             /**< number of indexed objects */
+    ndn_idx_match_t match;      /**< match function for resolving collisions */
+    uint16_t lencnt[NDN_IDX_COMP_MAX + 1];  /**< objects per name length */
+} ndn_idx_t;
+
+/**
+ * @brief   Initialize an index
+ *
+ * @param[out] idx      index to initialize
+ * @param[in] slots     memory for the hash table
+ * @param[in] numof     number of slots, must be a power of 2 and should be at
+ *                      least twice the number of indexed objects
+ * @param[in] match     match function for resolving collisions
+ */
+void ndn_idx_init(ndn_idx_t *idx, ndn_idx_slot_t *slots, unsigned numof,
+                  ndn_idx_match_t match);
+
+/**
+ * @brief   Add an object to the index
+ *
+ * @param[in,out] idx   index
+ * @param[in] name      TLV encoded name of the object
+ * @param[in] len       length of @p name in bytes
+ * @param[in] ptr       object to index
+ *
+ * @return  0 on success
+ * @return  -1 if the index is full or the name has too many components
+ */
+int ndn_idx_add(ndn_idx_t *idx, const uint8_t *name, size_t len,
+                const void *ptr);
+
+/**
+ * @brief   Remove an object from the index
+ *
+ * @param[in,out] idx   index
+ * @param[in] name      TLV encoded name of the object
+ * @param[in] len       length of @p name in bytes
+ * @param[in] ptr       object to remove
+ *
+ * @return  0 on success
+ * @return  -1 if @p ptr was not indexed
+ */
+int ndn_idx_del(ndn_idx_t *idx, const uint8_t *name, size_t len,
+                const void *ptr);
+
+/**
+ * @brief   Find an object with exactly the given name
+ *
+ * @param[in] idx       index
+ * @param[in] name      TLV encoded name
+ * @param[in] len       length of @p name in bytes
+ *
+ * @return  matching object
+ * @return  NULL if no object has the given name
+ */
+const void *ndn_idx_get(const ndn_idx_t *idx, const uint8_t *name, size_t len);
+
+/**
+ * @brief   Find the object with the longest name that is a prefix of the
+ *          given name
+ *
+ * @param[in] idx       index
+ * @param[in] name      TLV encoded name
+ * @param[in] len       length of @p name in bytes
+ *
+ * @return  object with the longest matching prefix
+ * @return  NULL if no indexed name is a prefix of @p name
+ */
+const void *ndn_idx_lpm(const ndn_idx_t *idx, const uint8_t *name, size_t len);
+
+/**
+ * @brief   Look up content in CCN-lite's content store by its exact name
+ *
+ * @note    Call this only from within CCN-lite's thread (e.g. from a local
+ *          producer or a @ref ndn_tap listener).
+ *
+ * @param[in] name      TLV encoded name
+ * @param[in] len       length of @p name in bytes
+ *
+ * @return  content store entry with the given name
+ * @return  NULL if the content store has no such entry
+ */
+struct ccnl_content_s *ndn_idx_cs_get(const uint8_t *name, size_t len);
+
+/**
+ * @brief   Get the number of indexed content store entries
+ *
+ * @note    Call this only from within CCN-lite's thread.
+ *
+ * @return  number of entries in the content store index
+ */
+unsigned ndn_idx_cs_numof(void);
+
+/**
+ * @brief   Shell command benchmarking indexed against linear lookups for a
+ *          range of table sizes
+ *
+ * @param[in] argc      number of arguments
+ * @param[in] argv      arguments
+ *
+ * @return  0 on success, 1 on error
+ */
+int ndn_idx_bench_cmd(int argc, char **argv);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* NDN_IDX_H */
+/** @} */
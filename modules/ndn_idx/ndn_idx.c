@@ -0,0 +1,355 @@
+/*
+ * Copyright (C) 2019 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     ndn_idx
+ * @{
+ *
+ * @file
+ * @brief       Hashed NDN name index implementation
+ *
+ * @author      Hauke Petersen <hauke.petersen@fu-berlin.de>
+ *
+ * @}
+ */
+
+#include <string.h>
+
+#include "assert.h"
+#include "ndn_tap.h"
+
+#include "ndn_idx.h"
+
+#define TLV_COMPONENT           (0x08)
+
+#define FNV_OFFSET              (2166136261u)
+#define FNV_PRIME               (16777619u)
+
+/* the original CCN-lite functions, resolved by the linker (--wrap) */
+struct ccnl_content_s *__real_ccnl_content_add2cache(struct ccnl_relay_s *ccnl,
+                                                     struct ccnl_content_s *c);
+struct ccnl_content_s *__real_ccnl_content_remove(struct ccnl_relay_s *ccnl,
+                                                  struct ccnl_content_s *c);
+int __real_ccnl_content_free(struct ccnl_content_s *c);
+
+static ndn_idx_slot_t _cs_slots[NDN_IDX_CS_SLOTS];
+static ndn_idx_t _cs;
+static int _cs_cnt = -1;        /* CS size the index was last synced to */
+static int _cs_complete = 0;    /* 0 if some CS entry could not be indexed */
+
+/* compute the hashes of all prefixes of the given name in a single pass,
+ * hashes[i] is the hash of the first i + 1 components */
+static int _hashes(const uint8_t *name, size_t len, uint32_t *hashes)
+{
+    const uint8_t *pos = name;
+    const uint8_t *end = name + len;
+    uint32_t hash = FNV_OFFSET;
+    unsigned comps = 0;
+
+    while (pos < end) {
+        const uint8_t *start = pos;
+        uint32_t type, tlen;
+        if ((ndn_tap_tlv(&pos, end, &type, &tlen) != 0) ||
+            (type != TLV_COMPONENT) || (comps >= NDN_IDX_COMP_MAX)) {
+            return -1;
+        }
+        pos += tlen;
+        /* hash the complete component TLV, so boundaries are preserved */
+        while (start < pos) {
+            hash = (hash ^ *start++) * FNV_PRIME;
+        }
+        hashes[comps++] = hash;
+    }
+
+    return (int)comps;
+}
+
+/* get the length of the first @p comps components of the given name */
+static size_t _prefix_len(const uint8_t *name, size_t len, unsigned comps)
+{
+    const uint8_t *pos = name;
+    const uint8_t *end = name + len;
+
+    while (comps-- && (pos < end)) {
+        uint32_t type, tlen;
+        ndn_tap_tlv(&pos, end, &type, &tlen);
+        pos += tlen;
+    }
+
+    return (size_t)(pos - name);
+}
+
+static const void *_find(const ndn_idx_t *idx, uint32_t hash, unsigned comps,
+                         const uint8_t *name, size_t len)
+{
+    for (unsigned i = (hash & idx->mask); idx->slots[i].ptr;
+         i = ((i + 1) & idx->mask)) {
+        const ndn_idx_slot_t *slot = &idx->slots[i];
+        if ((slot->hash == hash) && (slot->comps == comps) &&
+            idx->match(slot->ptr, name, len)) {
+            return slot->ptr;
+        }
+    }
+    return NULL;
+}
+
+void ndn_idx_init(ndn_idx_t *idx, ndn_idx_slot_t *slots, unsigned numof,
+                  ndn_idx_match_t match)
+{
+    assert((numof > 0) && ((numof & (numof - 1)) == 0));
+
+    memset(idx, 0, sizeof(ndn_idx_t));
+    memset(slots, 0, (numof * sizeof(ndn_idx_slot_t)));
+    idx->slots = slots;
+    idx->mask = numof - 1;
+    idx->match = match;
+}
+
+int ndn_idx_add(ndn_idx_t *idx, const uint8_t *name, size_t len,
+                const void *ptr)
+{
+    uint32_t hashes[NDN_IDX_COMP_MAX];
+    int comps = _hashes(name, len, hashes);
+
+    /* always keep one slot free, so probing terminates */
+    if ((comps < 0) || (idx->numof >= idx->mask)) {
+        return -1;
+    }
+
+    uint32_t hash = (comps > 0) ? hashes[comps - 1] : FNV_OFFSET;
+    unsigned i = (hash & idx->mask);
+    while (idx->slots[i].ptr) {
+        i = ((i + 1) & idx->mask);
+    }
+    idx->slots[i].ptr = ptr;
+    idx->slots[i].hash = hash;
+    idx->slots[i].comps = (uint8_t)comps;
+    idx->numof++;
+    idx->lencnt[comps]++;
+
+    return 0;
+}
+
+int ndn_idx_del(ndn_idx_t *idx, const uint8_t *name, size_t len,
+                const void *ptr)
+{
+    uint32_t hashes[NDN_IDX_COMP_MAX];
+    int comps = _hashes(name, len, hashes);
+    if (comps < 0) {
+        return -1;
+    }
+
+    uint32_t hash = (comps > 0) ? hashes[comps - 1] : FNV_OFFSET;
+    unsigned i = (hash & idx->mask);
+    while (idx->slots[i].ptr != ptr) {
+        if (idx->slots[i].ptr == NULL) {
+            return -1;
+        }
+        i = ((i + 1) & idx->mask);
+    }
+    idx->numof--;
+    idx->lencnt[comps]--;
+
+    /* backward shift deletion: move following entries of the same probe
+     * sequence up, so lookups never stop early at the freed slot */
+    unsigned j = i;
+    while (1) {
+        j = ((j + 1) & idx->mask);
+        if (idx->slots[j].ptr == NULL) {
+            break;
+        }
+        unsigned home = (idx->slots[j].hash & idx->mask);
+        if (((j > i) && ((home <= i) || (home > j))) ||
+            ((j < i) && ((home <= i) && (home > j)))) {
+            idx->slots[i] = idx->slots[j];
+            i = j;
+        }
+    }
+    idx->slots[i].ptr = NULL;
+
+    return 0;
+}
+
+const void *ndn_idx_get(const ndn_idx_t *idx, const uint8_t *name, size_t len)
+{
+    uint32_t hashes[NDN_IDX_COMP_MAX];
+    int comps = _hashes(name, len, hashes);
+
+    if ((comps < 0) || (idx->lencnt[comps] == 0)) {
+        return NULL;
+    }
+    uint32_t hash = (comps > 0) ? hashes[comps - 1] : FNV_OFFSET;
+    return _find(idx, hash, (unsigned)comps, name, len);
+}
+
+const void *ndn_idx_lpm(const ndn_idx_t *idx, const uint8_t *name, size_t len)
+{
+    uint32_t hashes[NDN_IDX_COMP_MAX];
+    int comps = _hashes(name, len, hashes);
+
+    if (comps < 0) {
+        return NULL;
+    }
+
+    /* only probe prefix lengths that are present in the index */
+    for (int c = comps; c > 0; c--) {
+        if (idx->lencnt[c] == 0) {
+            continue;
+        }
+        const void *res = _find(idx, hashes[c - 1], (unsigned)c, name,
+                                _prefix_len(name, len, (unsigned)c));
+        if (res) {
+            return res;
+        }
+    }
+
+    return (idx->lencnt[0]) ? _find(idx, FNV_OFFSET, 0, name, 0) : NULL;
+}
+
+static int _cs_name(const struct ccnl_content_s *c, ndn_tap_pkt_t *pkt)
+{
+    if ((c->pkt == NULL) || (c->pkt->buf == NULL)) {
+        return -1;
+    }
+    return ndn_tap_parse(c->pkt->buf->data, c->pkt->buf->datalen, pkt);
+}
+
+static int _cs_match(const void *ptr, const uint8_t *name, size_t len)
+{
+    ndn_tap_pkt_t pkt;
+    return ((_cs_name(ptr, &pkt) == 0) && (pkt.name_len == len) &&
+            (memcmp(pkt.name, name, len) == 0));
+}
+
+/* (re)index all entries of the content store */
+static void _cs_rebuild(struct ccnl_relay_s *relay)
+{
+    ndn_tap_pkt_t pkt;
+
+    ndn_idx_init(&_cs, _cs_slots, NDN_IDX_CS_SLOTS, _cs_match);
+    _cs_complete = 1;
+    for (struct ccnl_content_s *c = relay->contents; c; c = c->next) {
+        if ((_cs_name(c, &pkt) != 0) ||
+            (ndn_idx_add(&_cs, pkt.name, pkt.name_len, c) != 0)) {
+            _cs_complete = 0;
+        }
+    }
+    _cs_cnt = relay->contentcnt;
+}
+
+/* CCN-lite ages out entries from within its own compilation unit, where the
+ * linker can not wrap the call to ccnl_content_remove(). Every removal
+ * decrements the CS's entry count though, so we rebuild the index whenever
+ * that count changed behind our back, before any stale pointer is
+ * dereferenced */
+static void _cs_sync(struct ccnl_relay_s *relay)
+{
+    if ((_cs.slots == NULL) || (_cs_cnt != relay->contentcnt)) {
+        _cs_rebuild(relay);
+    }
+}
+
+struct ccnl_content_s *ndn_idx_cs_get(const uint8_t *name, size_t len)
+{
+    _cs_sync(&ccnl_relay);
+    if (_cs_complete) {
+        return (struct ccnl_content_s *)ndn_idx_get(&_cs, name, len);
+    }
+
+    /* not all entries fit into the index, so fall back to the list */
+    for (struct ccnl_content_s *c = ccnl_relay.contents; c; c = c->next) {
+        if (_cs_match(c, name, len)) {
+            return c;
+        }
+    }
+    return NULL;
+}
+
+unsigned ndn_idx_cs_numof(void)
+{
+    _cs_sync(&ccnl_relay);
+    return _cs.numof;
+}
+
+/* get the least recently used entry, the one CCN-lite would replace */
+static struct ccnl_content_s *_cs_oldest(struct ccnl_relay_s *relay)
+{
+    struct ccnl_content_s *oldest = NULL;
+
+    for (struct ccnl_content_s *c = relay->contents; c; c = c->next) {
+        if (!(c->flags & CCNL_CONTENT_FLAGS_STATIC) &&
+            ((oldest == NULL) || (c->last_used < oldest->last_used))) {
+            oldest = c;
+        }
+    }
+    return oldest;
+}
+
+struct ccnl_content_s *__wrap_ccnl_content_add2cache(struct ccnl_relay_s *ccnl,
+                                                     struct ccnl_content_s *c)
+{
+    ndn_tap_pkt_t pkt;
+    int named = (_cs_name(c, &pkt) == 0);
+
+    _cs_sync(ccnl);
+
+    /* replace an entry ourselves before CCN-lite does so internally, unless c
+     * is a duplicate that CCN-lite will reject anyway */
+    if ((ccnl->max_cache_entries > 0) &&
+        (ccnl->contentcnt >= ccnl->max_cache_entries) &&
+        !(named && _cs_complete &&
+          ndn_idx_get(&_cs, pkt.name, pkt.name_len))) {
+        struct ccnl_content_s *oldest = _cs_oldest(ccnl);
+        if (oldest) {
+            ccnl_content_remove(ccnl, oldest);
+        }
+    }
+
+    int cnt = ccnl->contentcnt;
+    struct ccnl_content_s *res = __real_ccnl_content_add2cache(ccnl, c);
+
+    if ((_cs_cnt != cnt) || (ccnl->contentcnt != (cnt + (res == c)))) {
+        /* CCN-lite dropped an entry on its own after all */
+        _cs_rebuild(ccnl);
+    }
+    else if (res == c) {
+        if (!named || (ndn_idx_add(&_cs, pkt.name, pkt.name_len, c) != 0)) {
+            _cs_complete = 0;
+        }
+        _cs_cnt = ccnl->contentcnt;
+    }
+    return res;
+}
+
+struct ccnl_content_s *__wrap_ccnl_content_remove(struct ccnl_relay_s *ccnl,
+                                                  struct ccnl_content_s *c)
+{
+    ndn_tap_pkt_t pkt;
+
+    /* ndn_idx_del() only compares pointers, so this is safe on a stale index */
+    if ((_cs.slots != NULL) && (_cs_name(c, &pkt) == 0)) {
+        ndn_idx_del(&_cs, pkt.name, pkt.name_len, c);
+    }
+    int cnt = ccnl->contentcnt;
+    struct ccnl_content_s *next = __real_ccnl_content_remove(ccnl, c);
+    if ((_cs_cnt == cnt) && (ccnl->contentcnt == (cnt - 1))) {
+        _cs_cnt = ccnl->contentcnt;
+    }
+    return next;
+}
+
+int __wrap_ccnl_content_free(struct ccnl_content_s *c)
+{
+    ndn_tap_pkt_t pkt;
+
+    /* content that never made it into the CS is simply not found */
+    if ((_cs.slots != NULL) && (_cs_name(c, &pkt) == 0)) {
+        ndn_idx_del(&_cs, pkt.name, pkt.name_len, c);
+    }
+    return __real_ccnl_content_free(c);
+}
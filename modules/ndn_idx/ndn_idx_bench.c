@@ -0,0 +1,205 @@
+/*
+ * Copyright (C) 2019 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     ndn_idx
+ * @{
+ *
+ * @file
+ * @brief       Lookup benchmark: hashed index vs. CCN-lite's linear matching
+ *
+ * @author      Hauke Petersen <hauke.petersen@fu-berlin.de>
+ *
+ * @}
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "fmt.h"
+#include "xtimer.h"
+#include "ndn_tap.h"
+
+#include "ndn_idx.h"
+
+#define BENCH_MAX               (128U)
+#define BENCH_DEFAULT           (64U)
+#define BENCH_ROUNDS            (500U)
+#define BENCH_NAMELEN           (40U)
+#define BENCH_URI_BASE          "/icn19/bench/"
+
+typedef struct entry {
+    struct entry *next;
+    struct ccnl_prefix_s *pfx;      /* table entry, as CCN-lite sees it */
+    struct ccnl_prefix_s *query;    /* longer name under the entry's name */
+    uint8_t name[BENCH_NAMELEN];
+    uint8_t qname[BENCH_NAMELEN];
+    uint8_t len;
+    uint8_t qlen;
+} entry_t;
+
+/* only allocated while the benchmark runs */
+static entry_t *_entries;
+static ndn_idx_slot_t *_slots;
+
+static int _match(const void *ptr, const uint8_t *name, size_t len)
+{
+    const entry_t *e = ptr;
+    return ((e->len == len) && (memcmp(e->name, name, len) == 0));
+}
+
+static int _setup(unsigned numof)
+{
+    char uri[BENCH_NAMELEN];
+
+    for (unsigned i = 0; i < numof; i++) {
+        entry_t *e = &_entries[i];
+        size_t pos = strlen(BENCH_URI_BASE);
+        memcpy(uri, BENCH_URI_BASE, pos);
+        pos += fmt_u32_dec(&uri[pos], i);
+        uri[pos] = '\0';
+        e->len = (uint8_t)ndn_tap_uri_to_name(uri, e->name, sizeof(e->name));
+        e->pfx = ndn_tap_uri_to_prefix(uri);
+        memcpy(&uri[pos], "/chunk", sizeof("/chunk"));
+        e->qlen = (uint8_t)ndn_tap_uri_to_name(uri, e->qname, sizeof(e->qname));
+        e->query = ndn_tap_uri_to_prefix(uri);
+        e->next = (i > 0) ? &_entries[i - 1] : NULL;
+        if ((e->pfx == NULL) || (e->query == NULL)) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static void _teardown(unsigned numof)
+{
+    for (unsigned i = 0; i < numof; i++) {
+        if (_entries[i].pfx) {
+            ccnl_prefix_free(_entries[i].pfx);
+        }
+        if (_entries[i].query) {
+            ccnl_prefix_free(_entries[i].query);
+        }
+        _entries[i].pfx = NULL;
+        _entries[i].query = NULL;
+    }
+}
+
+/* the lookup target of round r, spread over the complete table */
+static entry_t *_target(unsigned r, unsigned numof)
+{
+    return &_entries[(r * 7919) % numof];
+}
+
+static void _run(unsigned numof)
+{
+    entry_t *head = &_entries[numof - 1];
+    ndn_idx_t idx;
+    unsigned slots = 2;
+    unsigned found[4] = { 0 };
+    uint32_t t[4];
+
+    while (slots < (numof * 2)) {
+        slots <<= 1;
+    }
+    ndn_idx_init(&idx, _slots, slots, _match);
+    for (unsigned i = 0; i < numof; i++) {
+        ndn_idx_add(&idx, _entries[i].name, _entries[i].len, &_entries[i]);
+    }
+
+    /* exact match, walking the list like CCN-lite's content store */
+    t[0] = xtimer_now_usec();
+    for (unsigned r = 0; r < BENCH_ROUNDS; r++) {
+        entry_t *q = _target(r, numof);
+        for (entry_t *e = head; e; e = e->next) {
+            if (ccnl_prefix_cmp(e->pfx, NULL, q->pfx, CMP_EXACT) == 0) {
+                found[0]++;
+                break;
+            }
+        }
+    }
+    t[0] = xtimer_now_usec() - t[0];
+
+    t[1] = xtimer_now_usec();
+    for (unsigned r = 0; r < BENCH_ROUNDS; r++) {
+        entry_t *q = _target(r, numof);
+        found[1] += (ndn_idx_get(&idx, q->name, q->len) != NULL);
+    }
+    t[1] = xtimer_now_usec() - t[1];
+
+    /* longest prefix match, walking all entries like a FIB lookup */
+    t[2] = xtimer_now_usec();
+    for (unsigned r = 0; r < BENCH_ROUNDS; r++) {
+        entry_t *q = _target(r, numof);
+        entry_t *best = NULL;
+        int best_len = 0;
+        for (entry_t *e = head; e; e = e->next) {
+            int res = ccnl_prefix_cmp(e->pfx, NULL, q->query, CMP_LONGEST);
+            if ((res >= (int)e->pfx->compcnt) && (res > best_len)) {
+                best = e;
+                best_len = res;
+            }
+        }
+        found[2] += (best != NULL);
+    }
+    t[2] = xtimer_now_usec() - t[2];
+
+    t[3] = xtimer_now_usec();
+    for (unsigned r = 0; r < BENCH_ROUNDS; r++) {
+        entry_t *q = _target(r, numof);
+        found[3] += (ndn_idx_lpm(&idx, q->qname, q->qlen) != NULL);
+    }
+    t[3] = xtimer_now_usec() - t[3];
+
+    printf("%6u", numof);
+    for (unsigned i = 0; i < 4; i++) {
+        /* time per lookup in ns, flag runs that missed entries */
+        printf(" %11lu%c", (unsigned long)(((uint64_t)t[i] * 1000) / BENCH_ROUNDS),
+               (found[i] == BENCH_ROUNDS) ? ' ' : '!');
+    }
+    puts("");
+}
+
+int ndn_idx_bench_cmd(int argc, char **argv)
+{
+    unsigned max = (argc > 1) ? (unsigned)atoi(argv[1]) : BENCH_DEFAULT;
+
+    if ((max < 1) || (max > BENCH_MAX)) {
+        printf("usage: %s [<max entries, 1-%u>]\n", argv[0], BENCH_MAX);
+        return 1;
+    }
+
+    _entries = calloc(max, sizeof(entry_t));
+    _slots = calloc((max * 2), sizeof(ndn_idx_slot_t));
+    if ((_entries == NULL) || (_slots == NULL)) {
+        puts("err: out of memory");
+        free(_entries);
+        free(_slots);
+        return 1;
+    }
+
+    int res = 0;
+    printf("lookup time [ns], %u lookups per table size\n", BENCH_ROUNDS);
+    printf("%6s %12s %12s %12s %12s\n", "size", "exact-list", "exact-hash",
+           "lpm-list", "lpm-hash");
+    for (unsigned numof = 1; numof <= max; numof <<= 1) {
+        if (_setup(numof) != 0) {
+            puts("err: out of memory");
+            _teardown(numof);
+            res = 1;
+            break;
+        }
+        _run(numof);
+        _teardown(numof);
+    }
+
+    free(_entries);
+    free(_slots);
+    return res;
+}
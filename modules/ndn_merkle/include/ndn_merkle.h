@@ -0,0 +1,211 @@
+/*
+ * Copyright (C) 2019 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @defgroup    ndn_merkle Batch signatures for NDN Data
+ * @brief       Authenticate batches of small Data packets with a single tag
+ *
+ * Computing an HMAC for every 2 byte heart rate sample costs more than
+ * producing the sample. Instead, a producer collects the payloads of a batch of
+ * consecutive chunks into a Merkle tree and authenticates only the tree's root
+ * (using HMAC-SHA256 with a pre-shared key). Every Data packet then carries a
+ * trailer behind its payload:
+ *
+ *     payload | proof | batch (4 byte) | leaf (1 byte) | depth (1 byte) | tag | 0xb5
+ *
+ * The proof consists of the sibling hashes on the path from the payload's leaf
+ * to the root. A consumer recomputes the root from the payload and the proof.
+ * If that root is in its cache of verified roots, the Data is authentic without
+ * checking the tag, otherwise the tag is verified once and the root is cached.
+ *
+ * Leaves are bound to their position in the batch, so a payload can not be
+ * replayed as a different chunk of the same batch.
+ *
+ * @{
+ *
+ * @file
+ * @brief       Batch signature interface
+ *
+ * @author      Hauke Petersen <hauke.petersen@fu-berlin.de>
+ */
+
+#ifndef NDN_MERKLE_H
+#define NDN_MERKLE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief   Depth of the tree, a batch holds 2^depth chunks
+ */
+#ifndef NDN_MERKLE_DEPTH
+#define NDN_MERKLE_DEPTH        (3U)
+#endif
+
+/**
+ * @brief   Length of the (truncated) hashes in the tree and the proofs
+ */
+#ifndef NDN_MERKLE_HASHLEN
+#define NDN_MERKLE_HASHLEN      (16U)
+#endif
+
+/**
+ * @brief   Length of the (truncated) HMAC authenticating a batch's root
+ */
+#ifndef NDN_MERKLE_TAGLEN
+#define NDN_MERKLE_TAGLEN       (16U)
+#endif
+
+/**
+ * @brief   Key shared between producer and consumers
+ *
+ * There is no default, as a key in the sources would authenticate nothing.
+ * Set it when building, e.g. `NDN_MERKLE_KEY=<secret> make`.
+ */
+#if !defined(NDN_MERKLE_KEY) && !defined(DOXYGEN)
+#error "ndn_merkle: NDN_MERKLE_KEY is not set"
+#endif
+
+/**
+ * @brief   Number of verified roots a consumer remembers
+ */
+#ifndef NDN_MERKLE_CACHE_SIZE
+#define NDN_MERKLE_CACHE_SIZE   (4U)
+#endif
+
+/**
+ * @brief   Number of chunks per batch
+ */
+#define NDN_MERKLE_LEAVES       (1U << NDN_MERKLE_DEPTH)
+
+/**
+ * @brief   Length of the trailer appended to each payload
+ */
+#define NDN_MERKLE_TRAILER_LEN  ((NDN_MERKLE_DEPTH * NDN_MERKLE_HASHLEN) + \
+                                 NDN_MERKLE_TAGLEN + 7)
+
+/**
+ * @brief   Return values of ndn_merkle_verify()
+ */
+enum {
+    NDN_MERKLE_NOSIG = -1,      /**< content carries no batch signature */
+    NDN_MERKLE_INVALID = -2,    /**< signature present but not valid */
+};
+
+/**
+ * @brief   Producer side state of a batch
+ */
+typedef struct {
+    uint32_t batch;             /**< batch number */
+    unsigned numof;             /**< number of leaves added so far */
+    /** tree in heap order: tree[1] is the root, leaves start at tree[LEAVES] */
+    uint8_t tree[2 * NDN_MERKLE_LEAVES][NDN_MERKLE_HASHLEN];
+    uint8_t tag[NDN_MERKLE_TAGLEN];     /**< authentication tag of the root */
+} ndn_merkle_batch_t;
+
+/**
+ * @brief   Consumer side cache of verified roots
+ */
+typedef struct {
+    struct {
+        uint32_t batch;                     /**< batch number */
+        uint8_t root[NDN_MERKLE_HASHLEN];   /**< verified root */
+        uint8_t used;                       /**< 1 if the entry is valid */
+    } roots[NDN_MERKLE_CACHE_SIZE];         /**< verified roots */
+    unsigned next;              /**< entry replaced next */
+    uint32_t verified;          /**< number of successfully verified Data */
+    uint32_t tag_checks;        /**< number of tag verifications */
+    uint32_t failed;            /**< number of rejected Data */
+} ndn_merkle_cache_t;
+
+/**
+ * @brief   Start a new batch
+ *
+ * @param[out] b        batch to initialize
+ * @param[in] batch     batch number, chunk n belongs to batch n / LEAVES
+ */
+void ndn_merkle_batch_start(ndn_merkle_batch_t *b, uint32_t batch);
+
+/**
+ * @brief   Add the payload of the next chunk to a batch
+ *
+ * @param[in,out] b     batch
+ * @param[in] payload   payload of the chunk
+ * @param[in] len       length of @p payload in bytes
+ *
+ * @return  leaf index of the chunk
+ * @return  -1 if the batch is full
+ */
+int ndn_merkle_batch_add(ndn_merkle_batch_t *b, const void *payload,
+                         size_t len);
+
+/**
+ * @brief   Compute the root of a batch and its authentication tag
+ *
+ * Leaves that were not added are filled with the hash of an empty payload.
+ *
+ * @param[in,out] b     batch
+ */
+void ndn_merkle_batch_sign(ndn_merkle_batch_t *b);
+
+/**
+ * @brief   Write the trailer of the given leaf of a signed batch
+ *
+ * @param[in] b         signed batch
+ * @param[in] leaf      leaf index
+ * @param[out] buf      buffer to write the trailer to, must hold at least
+ *                      NDN_MERKLE_TRAILER_LEN bytes
+ *
+ * @return  NDN_MERKLE_TRAILER_LEN
+ */
+size_t ndn_merkle_trailer(const ndn_merkle_batch_t *b, unsigned leaf,
+                          uint8_t *buf);
+
+/**
+ * @brief   Initialize a cache of verified roots
+ *
+ * @param[out] cache    cache to initialize
+ */
+void ndn_merkle_cache_init(ndn_merkle_cache_t *cache);
+
+/**
+ * @brief   Verify the batch signature of the given content
+ *
+ * @param[in,out] cache cache of verified roots
+ * @param[in] data      content (payload and trailer)
+ * @param[in] len       length of @p data in bytes
+ * @param[out] chunk    chunk number the payload was signed for, may be NULL
+ *
+ * @return  length of the authenticated payload at the start of @p data
+ * @return  NDN_MERKLE_NOSIG if @p data carries no batch signature
+ * @return  NDN_MERKLE_INVALID if the signature is invalid
+ */
+int ndn_merkle_verify(ndn_merkle_cache_t *cache, const uint8_t *data,
+                      size_t len, uint32_t *chunk);
+
+/**
+ * @brief   Shell command comparing CPU time and byte overhead of batch
+ *          signatures against a per-packet HMAC
+ *
+ * @param[in] argc      number of arguments
+ * @param[in] argv      arguments
+ *
+ * @return  0 on success, 1 on error
+ */
+int ndn_merkle_bench_cmd(int argc, char **argv);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* NDN_MERKLE_H */
+/** @} */
@@ -0,0 +1,245 @@
+/*
+ * Copyright (C) 2019 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     ndn_merkle
+ * @{
+ *
+ * @file
+ * @brief       Batch signature implementation
+ *
+ * @author      Hauke Petersen <hauke.petersen@fu-berlin.de>
+ *
+ * @}
+ */
+
+#include <string.h>
+
+#include "assert.h"
+#include "hashes/sha256.h"
+
+#include "ndn_merkle.h"
+
+#define MARKER                  (0xb5)
+/* domain separation of leaf and inner node hashes */
+#define PREFIX_LEAF             (0x00)
+#define PREFIX_NODE             (0x01)
+
+#define KEY                     NDN_MERKLE_KEY
+#define KEYLEN                  (sizeof(NDN_MERKLE_KEY) - 1)
+
+static void _put_u32(uint8_t *buf, uint32_t val)
+{
+    buf[0] = (uint8_t)(val >> 24);
+    buf[1] = (uint8_t)(val >> 16);
+    buf[2] = (uint8_t)(val >> 8);
+    buf[3] = (uint8_t)val;
+}
+
+static uint32_t _get_u32(const uint8_t *buf)
+{
+    return (((uint32_t)buf[0] << 24) | ((uint32_t)buf[1] << 16) |
+            ((uint32_t)buf[2] << 8) | buf[3]);
+}
+
+static void _leaf(uint8_t *out, uint32_t batch, unsigned leaf,
+                  const void *payload, size_t len)
+{
+    sha256_context_t ctx;
+    uint8_t digest[SHA256_DIGEST_LENGTH];
+    uint8_t hdr[6];
+
+    hdr[0] = PREFIX_LEAF;
+    _put_u32(&hdr[1], batch);
+    hdr[5] = (uint8_t)leaf;
+    sha256_init(&ctx);
+    sha256_update(&ctx, hdr, sizeof(hdr));
+    sha256_update(&ctx, payload, len);
+    sha256_final(&ctx, digest);
+    memcpy(out, digest, NDN_MERKLE_HASHLEN);
+}
+
+/* @p out may alias @p left or @p right */
+static void _node(uint8_t *out, const uint8_t *left, const uint8_t *right)
+{
+    sha256_context_t ctx;
+    uint8_t digest[SHA256_DIGEST_LENGTH];
+    uint8_t prefix = PREFIX_NODE;
+
+    sha256_init(&ctx);
+    sha256_update(&ctx, &prefix, 1);
+    sha256_update(&ctx, left, NDN_MERKLE_HASHLEN);
+    sha256_update(&ctx, right, NDN_MERKLE_HASHLEN);
+    sha256_final(&ctx, digest);
+    memcpy(out, digest, NDN_MERKLE_HASHLEN);
+}
+
+static void _tag(uint8_t *out, uint32_t batch, const uint8_t *root)
+{
+    hmac_context_t ctx;
+    uint8_t digest[SHA256_DIGEST_LENGTH];
+    uint8_t hdr[5];
+
+    _put_u32(hdr, batch);
+    hdr[4] = NDN_MERKLE_DEPTH;
+    hmac_sha256_init(&ctx, KEY, KEYLEN);
+    hmac_sha256_update(&ctx, hdr, sizeof(hdr));
+    hmac_sha256_update(&ctx, root, NDN_MERKLE_HASHLEN);
+    hmac_sha256_final(&ctx, digest);
+    memcpy(out, digest, NDN_MERKLE_TAGLEN);
+}
+
+/* compare without leaking the position of the first difference */
+static int _equal(const uint8_t *a, const uint8_t *b, size_t len)
+{
+    uint8_t diff = 0;
+    for (size_t i = 0; i < len; i++) {
+        diff |= (a[i] ^ b[i]);
+    }
+    return (diff == 0);
+}
+
+void ndn_merkle_batch_start(ndn_merkle_batch_t *b, uint32_t batch)
+{
+    memset(b, 0, sizeof(ndn_merkle_batch_t));
+    b->batch = batch;
+}
+
+int ndn_merkle_batch_add(ndn_merkle_batch_t *b, const void *payload,
+                         size_t len)
+{
+    if (b->numof >= NDN_MERKLE_LEAVES) {
+        return -1;
+    }
+    _leaf(b->tree[NDN_MERKLE_LEAVES + b->numof], b->batch, b->numof,
+          payload, len);
+    return (int)b->numof++;
+}
+
+void ndn_merkle_batch_sign(ndn_merkle_batch_t *b)
+{
+    for (unsigned i = b->numof; i < NDN_MERKLE_LEAVES; i++) {
+        _leaf(b->tree[NDN_MERKLE_LEAVES + i], b->batch, i, "", 0);
+    }
+    for (unsigned n = (NDN_MERKLE_LEAVES - 1); n > 0; n--) {
+        _node(b->tree[n], b->tree[2 * n], b->tree[(2 * n) + 1]);
+    }
+    _tag(b->tag, b->batch, b->tree[1]);
+}
+
+size_t ndn_merkle_trailer(const ndn_merkle_batch_t *b, unsigned leaf,
+                          uint8_t *buf)
+{
+    uint8_t *pos = buf;
+
+    assert(leaf < NDN_MERKLE_LEAVES);
+
+    /* sibling hashes from the leaf up to the root */
+    for (unsigned n = (NDN_MERKLE_LEAVES + leaf); n > 1; n >>= 1) {
+        memcpy(pos, b->tree[n ^ 1], NDN_MERKLE_HASHLEN);
+        pos += NDN_MERKLE_HASHLEN;
+    }
+    _put_u32(pos, b->batch);
+    pos[4] = (uint8_t)leaf;
+    pos[5] = NDN_MERKLE_DEPTH;
+    pos += 6;
+    memcpy(pos, b->tag, NDN_MERKLE_TAGLEN);
+    pos += NDN_MERKLE_TAGLEN;
+    *pos++ = MARKER;
+
+    return (size_t)(pos - buf);
+}
+
+void ndn_merkle_cache_init(ndn_merkle_cache_t *cache)
+{
+    memset(cache, 0, sizeof(ndn_merkle_cache_t));
+}
+
+static int _cached(const ndn_merkle_cache_t *cache, uint32_t batch,
+                   const uint8_t *root)
+{
+    for (unsigned i = 0; i < NDN_MERKLE_CACHE_SIZE; i++) {
+        if (cache->roots[i].used && (cache->roots[i].batch == batch) &&
+            (memcmp(cache->roots[i].root, root, NDN_MERKLE_HASHLEN) == 0)) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static void _cache_add(ndn_merkle_cache_t *cache, uint32_t batch,
+                       const uint8_t *root)
+{
+    unsigned slot = NDN_MERKLE_CACHE_SIZE;
+
+    /* a root per batch is enough, replace the oldest one otherwise */
+    for (unsigned i = 0; i < NDN_MERKLE_CACHE_SIZE; i++) {
+        if (cache->roots[i].used && (cache->roots[i].batch == batch)) {
+            slot = i;
+            break;
+        }
+    }
+    if (slot == NDN_MERKLE_CACHE_SIZE) {
+        slot = cache->next;
+        cache->next = ((cache->next + 1) % NDN_MERKLE_CACHE_SIZE);
+    }
+    cache->roots[slot].batch = batch;
+    memcpy(cache->roots[slot].root, root, NDN_MERKLE_HASHLEN);
+    cache->roots[slot].used = 1;
+}
+
+int ndn_merkle_verify(ndn_merkle_cache_t *cache, const uint8_t *data,
+                      size_t len, uint32_t *chunk)
+{
+    if ((len < NDN_MERKLE_TRAILER_LEN) || (data[len - 1] != MARKER)) {
+        return NDN_MERKLE_NOSIG;
+    }
+
+    size_t plen = len - NDN_MERKLE_TRAILER_LEN;
+    const uint8_t *proof = &data[plen];
+    const uint8_t *pos = &proof[NDN_MERKLE_DEPTH * NDN_MERKLE_HASHLEN];
+    uint32_t batch = _get_u32(pos);
+    unsigned leaf = pos[4];
+    const uint8_t *tag = &pos[6];
+    uint8_t hash[NDN_MERKLE_HASHLEN];
+
+    if ((pos[5] != NDN_MERKLE_DEPTH) || (leaf >= NDN_MERKLE_LEAVES)) {
+        cache->failed++;
+        return NDN_MERKLE_INVALID;
+    }
+
+    /* fold the proof into the root */
+    _leaf(hash, batch, leaf, data, plen);
+    for (unsigned n = (NDN_MERKLE_LEAVES + leaf); n > 1; n >>= 1) {
+        if (n & 1) {
+            _node(hash, proof, hash);
+        }
+        else {
+            _node(hash, hash, proof);
+        }
+        proof += NDN_MERKLE_HASHLEN;
+    }
+
+    /* only roots not seen before need their tag checked */
+    if (!_cached(cache, batch, hash)) {
+        uint8_t expected[NDN_MERKLE_TAGLEN];
+        _tag(expected, batch, hash);
+        cache->tag_checks++;
+        if (!_equal(expected, tag, NDN_MERKLE_TAGLEN)) {
+            cache->failed++;
+            return NDN_MERKLE_INVALID;
+        }
+        _cache_add(cache, batch, hash);
+    }
+
+    cache->verified++;
+    if (chunk) {
+        *chunk = (batch * NDN_MERKLE_LEAVES) + leaf;
+    }
+    return (int)plen;
+}
@@ -0,0 +1,158 @@
+/*
+ * Copyright (C) 2019 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     ndn_merkle
+ * @{
+ *
+ * @file
+ * @brief       Benchmark: batch signatures vs. per-packet HMAC
+ *
+ * @author      Hauke Petersen <hauke.petersen@fu-berlin.de>
+ *
+ * @}
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "xtimer.h"
+#include "hashes/sha256.h"
+
+#include "ndn_merkle.h"
+
+#define BENCH_DEFAULT           (32U)       /* batches */
+#define BENCH_MAX               (1024U)
+#define PAYLOAD_LEN             (2U)        /* a heart rate sample */
+
+typedef struct {
+    uint8_t data[PAYLOAD_LEN + NDN_MERKLE_TRAILER_LEN];
+    size_t len;
+} content_t;
+
+static ndn_merkle_batch_t _batch;
+static ndn_merkle_cache_t _cache;
+static content_t _contents[NDN_MERKLE_LEAVES];
+
+static void _sample(uint32_t chunk, uint8_t *buf)
+{
+    uint16_t bpm = (uint16_t)(80 + (chunk % 40));
+    memcpy(buf, &bpm, PAYLOAD_LEN);
+}
+
+/* the per-packet alternative: an HMAC over chunk number and payload */
+static void _hmac(uint32_t chunk, const uint8_t *payload, uint8_t *tag)
+{
+    hmac_context_t ctx;
+    uint8_t digest[SHA256_DIGEST_LENGTH];
+
+    hmac_sha256_init(&ctx, NDN_MERKLE_KEY, (sizeof(NDN_MERKLE_KEY) - 1));
+    hmac_sha256_update(&ctx, &chunk, sizeof(chunk));
+    hmac_sha256_update(&ctx, payload, PAYLOAD_LEN);
+    hmac_sha256_final(&ctx, digest);
+    memcpy(tag, digest, NDN_MERKLE_TAGLEN);
+}
+
+static void _sign_batch(uint32_t batch)
+{
+    uint8_t payload[PAYLOAD_LEN];
+
+    ndn_merkle_batch_start(&_batch, batch);
+    for (unsigned i = 0; i < NDN_MERKLE_LEAVES; i++) {
+        _sample((batch * NDN_MERKLE_LEAVES) + i, payload);
+        ndn_merkle_batch_add(&_batch, payload, PAYLOAD_LEN);
+    }
+    ndn_merkle_batch_sign(&_batch);
+    for (unsigned i = 0; i < NDN_MERKLE_LEAVES; i++) {
+        _sample((batch * NDN_MERKLE_LEAVES) + i, _contents[i].data);
+        _contents[i].len = PAYLOAD_LEN +
+                           ndn_merkle_trailer(&_batch, i,
+                                              &_contents[i].data[PAYLOAD_LEN]);
+    }
+}
+
+static void _print(const char *mode, uint32_t sign, uint32_t verify,
+                   unsigned chunks, unsigned overhead)
+{
+    /* CPU time per Data in ns */
+    printf("%-8s %10lu %10lu %10u\n", mode,
+           (unsigned long)(((uint64_t)sign * 1000) / chunks),
+           (unsigned long)(((uint64_t)verify * 1000) / chunks), overhead);
+}
+
+int ndn_merkle_bench_cmd(int argc, char **argv)
+{
+    unsigned batches = (argc > 1) ? (unsigned)atoi(argv[1]) : BENCH_DEFAULT;
+    unsigned chunks = batches * NDN_MERKLE_LEAVES;
+    uint8_t payload[PAYLOAD_LEN];
+    uint8_t tags[NDN_MERKLE_LEAVES][NDN_MERKLE_TAGLEN];
+    uint8_t check[NDN_MERKLE_TAGLEN];
+    unsigned failed = 0;
+    uint32_t t_sign = 0;
+    uint32_t t_verify = 0;
+    uint32_t start;
+
+    if ((batches < 1) || (batches > BENCH_MAX)) {
+        printf("usage: %s [<batches, 1-%u>]\n", argv[0], BENCH_MAX);
+        return 1;
+    }
+
+    printf("%u chunks of %u byte, %u chunks per batch\n", chunks, PAYLOAD_LEN,
+           NDN_MERKLE_LEAVES);
+    printf("%-8s %10s %10s %10s\n", "mode", "sign [ns]", "verify [ns]",
+           "bytes");
+
+    /* per-packet HMAC, timed in batches as well to keep timer overhead equal */
+    for (uint32_t b = 0; b < batches; b++) {
+        uint32_t first = b * NDN_MERKLE_LEAVES;
+        start = xtimer_now_usec();
+        for (unsigned i = 0; i < NDN_MERKLE_LEAVES; i++) {
+            _sample((first + i), payload);
+            _hmac((first + i), payload, tags[i]);
+        }
+        t_sign += xtimer_now_usec() - start;
+        start = xtimer_now_usec();
+        for (unsigned i = 0; i < NDN_MERKLE_LEAVES; i++) {
+            _sample((first + i), payload);
+            _hmac((first + i), payload, check);
+            failed += (memcmp(tags[i], check, NDN_MERKLE_TAGLEN) != 0);
+        }
+        t_verify += xtimer_now_usec() - start;
+    }
+    _print("hmac", t_sign, t_verify, chunks, NDN_MERKLE_TAGLEN);
+
+    /* batch signatures, including the trailer of every chunk */
+    ndn_merkle_cache_init(&_cache);
+    t_sign = 0;
+    t_verify = 0;
+    for (uint32_t b = 0; b < batches; b++) {
+        start = xtimer_now_usec();
+        _sign_batch(b);
+        t_sign += xtimer_now_usec() - start;
+        start = xtimer_now_usec();
+        for (unsigned i = 0; i < NDN_MERKLE_LEAVES; i++) {
+            uint32_t chunk;
+            int res = ndn_merkle_verify(&_cache, _contents[i].data,
+                                        _contents[i].len, &chunk);
+            failed += ((res != (int)PAYLOAD_LEN) ||
+                       (chunk != ((b * NDN_MERKLE_LEAVES) + i)));
+        }
+        t_verify += xtimer_now_usec() - start;
+    }
+    _print("merkle", t_sign, t_verify, chunks, NDN_MERKLE_TRAILER_LEN);
+
+    printf("tag checks: %lu for %lu verified Data\n",
+           (unsigned long)_cache.tag_checks, (unsigned long)_cache.verified);
+    if (failed) {
+        printf("err: %u chunks failed to verify\n", failed);
+        return 1;
+    }
+
+    return 0;
+}
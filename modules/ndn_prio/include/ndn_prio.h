@@ -0,0 +1,168 @@
+/*
+ * Copyright (C) 2019 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @defgroup    ndn_prio Prefix based NDN traffic classes
+ * @brief       Priority scheduling of outgoing NDN packets
+ *
+ * All packets CCN-lite sends are put into one transmit queue per traffic class
+ * (using the @ref ndn_tap transmit hook). A dedicated thread drains these
+ * queues towards the link layer, either in strict priority order or weighted
+ * round robin.
+ *
+ * Packets are mapped to classes by longest prefix match on their name. Names
+ * not matching any configured prefix end up in NDN_PRIO_CLS_DEFAULT.
+ *
+ * The transmit thread runs below CCN-lite's thread, so packets CCN-lite sends
+ * while handling a received packet or a timeout queue up and are handed to the
+ * link layer in class order once CCN-lite is done. In addition, the thread
+ * passes at most `burst` packets per connection interval to each BLE
+ * connection, which roughly matches what the link can carry per connection
+ * event. Without this pacing the link layer would take all packets at once and
+ * send them in FIFO order. Packets for destinations without a known connection
+ * (e.g. broadcast) are paced using the default interval instead.
+ *
+ * @{
+ *
+ * @file
+ * @brief       NDN priority scheduler interface
+ *
+ * @author      Hauke Petersen <hauke.petersen@fu-berlin.de>
+ */
+
+#ifndef NDN_PRIO_H
+#define NDN_PRIO_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief   Number of traffic classes, 0 is the highest priority
+ */
+#ifndef NDN_PRIO_CLS_NUMOF
+#define NDN_PRIO_CLS_NUMOF      (3U)
+#endif
+
+/**
+ * @brief   Traffic class used for names not matching any configured prefix
+ */
+#ifndef NDN_PRIO_CLS_DEFAULT
+#define NDN_PRIO_CLS_DEFAULT    (1U)
+#endif
+
+/**
+ * @brief   Maximum number of configured prefixes
+ */
+#ifndef NDN_PRIO_PREFIX_NUMOF
+#define NDN_PRIO_PREFIX_NUMOF   (8U)
+#endif
+
+/**
+ * @brief   Maximum length of a TLV encoded prefix in bytes
+ */
+#ifndef NDN_PRIO_PREFIX_MAXLEN
+#define NDN_PRIO_PREFIX_MAXLEN  (32U)
+#endif
+
+/**
+ * @brief   Maximum number of queued packets per class, further packets are
+ *          dropped
+ */
+#ifndef NDN_PRIO_QUEUE_MAXLEN
+#define NDN_PRIO_QUEUE_MAXLEN   (8U)
+#endif
+
+/**
+ * @brief   Default number of packets passed to the link layer per connection
+ *          interval and destination, 0 disables pacing
+ */
+#ifndef NDN_PRIO_BURST
+#define NDN_PRIO_BURST          (2U)
+#endif
+
+/**
+ * @brief   Pacing interval used for destinations without a known BLE
+ *          connection [ms]
+ */
+#ifndef NDN_PRIO_ITVL
+#define NDN_PRIO_ITVL           (75U)
+#endif
+
+/**
+ * @brief   Number of destinations paced in parallel, should match the number
+ *          of BLE connections
+ */
+#ifndef NDN_PRIO_DEST_NUMOF
+#define NDN_PRIO_DEST_NUMOF     (4U)
+#endif
+
+/**
+ * @brief   Maximum link layer address length of a destination in bytes
+ */
+#ifndef NDN_PRIO_ADDR_MAXLEN
+#define NDN_PRIO_ADDR_MAXLEN    (8U)
+#endif
+
+/**
+ * @brief   Scheduling modes
+ */
+typedef enum {
+    NDN_PRIO_STRICT,            /**< always serve the highest class first */
+    NDN_PRIO_WRR,               /**< weighted round robin between classes */
+} ndn_prio_mode_t;
+
+/**
+ * @brief   Initialize the scheduler and start its transmit thread
+ *
+ * @note    Must be called before CCN-lite is started.
+ */
+void ndn_prio_init(void);
+
+/**
+ * @brief   Map all names under the given prefix to a traffic class
+ *
+ * Setting the class of an already configured prefix updates its class.
+ *
+ * @param[in] prefix    name prefix as URI, e.g. `/icn19/watch/hrs`
+ * @param[in] cls       traffic class
+ *
+ * @return  0 on success
+ * @return  -1 if the prefix is invalid or there is no space left
+ */
+int ndn_prio_add(const char *prefix, unsigned cls);
+
+/**
+ * @brief   Remove a prefix mapping
+ *
+ * @param[in] prefix    name prefix as URI
+ *
+ * @return  0 on success
+ * @return  -1 if the prefix is not configured
+ */
+int ndn_prio_del(const char *prefix);
+
+/**
+ * @brief   Shell command for configuring the scheduler and printing its
+ *          per class statistics
+ *
+ * @param[in] argc      number of arguments
+ * @param[in] argv      arguments
+ *
+ * @return  0 on success, 1 on error
+ */
+int ndn_prio_cmd(int argc, char **argv);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* NDN_PRIO_H */
+/** @} */
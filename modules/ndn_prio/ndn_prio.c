@@ -0,0 +1,517 @@
+/*
+ * Copyright (C) 2019 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     ndn_prio
+ * @{
+ *
+ * @file
+ * @brief       NDN priority scheduler implementation
+ *
+ * @author      Hauke Petersen <hauke.petersen@fu-berlin.de>
+ *
+ * @}
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "assert.h"
+#include "mutex.h"
+#include "thread.h"
+#include "thread_flags.h"
+#include "xtimer.h"
+#include "ndn_tap.h"
+
+#include "ndn_prio.h"
+
+#ifdef MODULE_NIMBLE_NETIF
+#include "host/ble_gap.h"
+#include "net/bluetil/addr.h"
+#include "nimble_netif_conn.h"
+#endif
+
+/* run below CCN-lite, so packets it sends in a row can queue up */
+#define PRIO                    (CCNL_THREAD_PRIORITY + 1)
+#define STACKSIZE               (THREAD_STACKSIZE_DEFAULT)
+#define FLAG_TX                 (0x0001)
+
+typedef struct qpkt {
+    struct qpkt *next;
+    struct ccnl_relay_s *relay;
+    struct ccnl_if_s *ifc;
+    sockunion dest;
+    uint32_t t_enq;
+    struct ccnl_buf_s *buf;
+} qpkt_t;
+
+typedef struct {
+    qpkt_t *head;
+    qpkt_t *tail;
+    unsigned len;
+    unsigned credit;
+} queue_t;
+
+typedef struct {
+    uint32_t enq;
+    uint32_t sent;
+    uint32_t drop;
+    unsigned max_len;
+    uint32_t delay_max;
+    uint64_t delay_sum;
+} cls_stats_t;
+
+typedef struct {
+    uint8_t name[NDN_PRIO_PREFIX_MAXLEN];
+    uint8_t len;
+    uint8_t cls;
+} prefix_t;
+
+typedef struct {
+    uint8_t addr[NDN_PRIO_ADDR_MAXLEN];
+    uint8_t addr_len;
+    unsigned sent;
+    uint32_t start;
+    uint32_t itvl;
+} dest_t;
+
+static char _stack[STACKSIZE];
+static thread_t *_tx_thread;
+static xtimer_t _timer;
+static mutex_t _lock = MUTEX_INIT;
+
+static queue_t _q[NDN_PRIO_CLS_NUMOF];
+static cls_stats_t _stats[NDN_PRIO_CLS_NUMOF];
+static unsigned _weight[NDN_PRIO_CLS_NUMOF];
+static prefix_t _prefixes[NDN_PRIO_PREFIX_NUMOF];
+static dest_t _dests[NDN_PRIO_DEST_NUMOF];
+static ndn_prio_mode_t _mode = NDN_PRIO_STRICT;
+static unsigned _burst = NDN_PRIO_BURST;
+static uint32_t _itvl = (NDN_PRIO_ITVL * US_PER_MS);
+
+/* get the connection interval towards the given link layer address */
+static uint32_t _dest_itvl(const dest_t *d)
+{
+#ifdef MODULE_NIMBLE_NETIF
+    uint8_t addr[BLE_ADDR_LEN];
+    struct ble_gap_conn_desc desc;
+
+    if (d->addr_len == BLE_ADDR_LEN) {
+        bluetil_addr_swapped_cp(d->addr, addr);
+        int handle = nimble_netif_conn_get_by_addr(addr);
+        nimble_netif_conn_t *conn = nimble_netif_conn_get(handle);
+        if (conn && (ble_gap_conn_find(conn->gaphandle, &desc) == 0)) {
+            /* the connection interval is given in units of 1.25ms */
+            return (uint32_t)desc.conn_itvl * 1250;
+        }
+    }
+#else
+    (void)d;
+#endif
+    return _itvl;
+}
+
+/* must be called with _lock held */
+static dest_t *_dest_get(const sockunion *dest, uint32_t now)
+{
+    const uint8_t *addr = dest->linklayer.sll_addr;
+    size_t addr_len = dest->linklayer.sll_halen;
+    dest_t *d = &_dests[0];
+
+    if (addr_len > NDN_PRIO_ADDR_MAXLEN) {
+        addr_len = NDN_PRIO_ADDR_MAXLEN;
+    }
+
+    for (unsigned i = 0; i < NDN_PRIO_DEST_NUMOF; i++) {
+        if ((_dests[i].addr_len == addr_len) &&
+            (memcmp(_dests[i].addr, addr, addr_len) == 0)) {
+            d = &_dests[i];
+            break;
+        }
+        /* otherwise reuse the destination that was idle the longest */
+        if ((now - _dests[i].start) > (now - d->start)) {
+            d = &_dests[i];
+        }
+    }
+
+    if ((d->addr_len != addr_len) || (memcmp(d->addr, addr, addr_len) != 0)) {
+        memcpy(d->addr, addr, addr_len);
+        d->addr_len = (uint8_t)addr_len;
+        d->itvl = 0;
+    }
+    /* start a new connection interval */
+    if ((d->itvl == 0) || ((now - d->start) >= d->itvl)) {
+        d->start = now;
+        d->sent = 0;
+        d->itvl = _dest_itvl(d);
+    }
+
+    return d;
+}
+
+/* must be called with _lock held */
+static unsigned _classify(const uint8_t *data, size_t len)
+{
+    ndn_tap_pkt_t pkt;
+    unsigned cls = NDN_PRIO_CLS_DEFAULT;
+    size_t best = 0;
+
+    if (ndn_tap_parse(data, len, &pkt) != 0) {
+        return cls;
+    }
+
+    /* longest prefix match, TLV encoding preserves component boundaries */
+    for (unsigned i = 0; i < NDN_PRIO_PREFIX_NUMOF; i++) {
+        prefix_t *p = &_prefixes[i];
+        if ((p->len > 0) && (p->len > best) && (p->len <= pkt.name_len) &&
+            (memcmp(pkt.name, p->name, p->len) == 0)) {
+            best = p->len;
+            cls = p->cls;
+        }
+    }
+
+    return cls;
+}
+
+static void _enqueue(struct ccnl_relay_s *relay, struct ccnl_if_s *ifc,
+                     sockunion *dest, struct ccnl_buf_s *buf)
+{
+    mutex_lock(&_lock);
+    unsigned cls = _classify(buf->data, buf->datalen);
+    queue_t *q = &_q[cls];
+    if (q->len >= NDN_PRIO_QUEUE_MAXLEN) {
+        _stats[cls].drop++;
+        mutex_unlock(&_lock);
+        return;
+    }
+    mutex_unlock(&_lock);
+
+    /* CCN-lite frees the given buffer once we return, so we need a copy */
+    qpkt_t *qp = ccnl_malloc(sizeof(qpkt_t));
+    struct ccnl_buf_s *copy = ccnl_buf_new(buf->data, buf->datalen);
+    if ((qp == NULL) || (copy == NULL)) {
+        ccnl_free(qp);
+        ccnl_free(copy);
+        mutex_lock(&_lock);
+        _stats[cls].drop++;
+        mutex_unlock(&_lock);
+        return;
+    }
+    qp->next = NULL;
+    qp->relay = relay;
+    qp->ifc = ifc;
+    memcpy(&qp->dest, dest, sizeof(sockunion));
+    qp->t_enq = xtimer_now_usec();
+    qp->buf = copy;
+
+    mutex_lock(&_lock);
+    if (q->tail) {
+        q->tail->next = qp;
+    }
+    else {
+        q->head = qp;
+    }
+    q->tail = qp;
+    q->len++;
+    _stats[cls].enq++;
+    if (q->len > _stats[cls].max_len) {
+        _stats[cls].max_len = q->len;
+    }
+    mutex_unlock(&_lock);
+
+    thread_flags_set(_tx_thread, FLAG_TX);
+}
+
+/* must be called with _lock held */
+static qpkt_t *_pop(unsigned cls, qpkt_t *prev)
+{
+    queue_t *q = &_q[cls];
+    qpkt_t *qp = (prev) ? prev->next : q->head;
+
+    if (prev) {
+        prev->next = qp->next;
+    }
+    else {
+        q->head = qp->next;
+    }
+    if (q->tail == qp) {
+        q->tail = prev;
+    }
+    q->len--;
+
+    uint32_t delay = xtimer_now_usec() - qp->t_enq;
+    _stats[cls].sent++;
+    _stats[cls].delay_sum += delay;
+    if (delay > _stats[cls].delay_max) {
+        _stats[cls].delay_max = delay;
+    }
+
+    return qp;
+}
+
+/* get the oldest packet of a class whose connection can take another packet
+ * in its current interval, must be called with _lock held */
+static qpkt_t *_next(unsigned cls, uint32_t now, uint32_t *wait)
+{
+    qpkt_t *prev = NULL;
+
+    for (qpkt_t *qp = _q[cls].head; qp; qp = qp->next) {
+        if (_burst == 0) {
+            return _pop(cls, prev);
+        }
+        dest_t *d = _dest_get(&qp->dest, now);
+        if (d->sent < _burst) {
+            d->sent++;
+            return _pop(cls, prev);
+        }
+        uint32_t left = d->itvl - (now - d->start);
+        if (left < *wait) {
+            *wait = left;
+        }
+        prev = qp;
+    }
+
+    return NULL;
+}
+
+/* must be called with _lock held */
+static qpkt_t *_dequeue(uint32_t now, uint32_t *wait)
+{
+    qpkt_t *qp;
+
+    if (_mode == NDN_PRIO_STRICT) {
+        for (unsigned i = 0; i < NDN_PRIO_CLS_NUMOF; i++) {
+            if ((qp = _next(i, now, wait)) != NULL) {
+                return qp;
+            }
+        }
+        return NULL;
+    }
+
+    /* weighted round robin: serve backlogged classes while they have credit
+     * left, refill all credits once they are used up */
+    for (unsigned round = 0; round < 2; round++) {
+        for (unsigned i = 0; i < NDN_PRIO_CLS_NUMOF; i++) {
+            if ((_q[i].credit > 0) && ((qp = _next(i, now, wait)) != NULL)) {
+                _q[i].credit--;
+                return qp;
+            }
+        }
+        for (unsigned i = 0; i < NDN_PRIO_CLS_NUMOF; i++) {
+            _q[i].credit = _weight[i];
+        }
+    }
+
+    return NULL;
+}
+
+static void _wakeup(void *arg)
+{
+    (void)arg;
+    thread_flags_set(_tx_thread, FLAG_TX);
+}
+
+static void *_tx_loop(void *arg)
+{
+    (void)arg;
+
+    while (1) {
+        thread_flags_wait_any(FLAG_TX);
+
+        while (1) {
+            uint32_t wait = UINT32_MAX;
+
+            mutex_lock(&_lock);
+            qpkt_t *qp = _dequeue(xtimer_now_usec(), &wait);
+            mutex_unlock(&_lock);
+
+            if (qp == NULL) {
+                /* all remaining packets wait for their next connection
+                 * interval, or the queues are empty */
+                if (wait != UINT32_MAX) {
+                    xtimer_set(&_timer, wait);
+                }
+                break;
+            }
+            ndn_tap_tx(qp->relay, qp->ifc, &qp->dest, qp->buf);
+            ccnl_free(qp->buf);
+            ccnl_free(qp);
+        }
+    }
+
+    /* never reached */
+    return NULL;
+}
+
+void ndn_prio_init(void)
+{
+    for (unsigned i = 0; i < NDN_PRIO_CLS_NUMOF; i++) {
+        /* by default, higher classes get a larger share */
+        _weight[i] = NDN_PRIO_CLS_NUMOF - i;
+        _q[i].credit = _weight[i];
+    }
+
+    kernel_pid_t pid = thread_create(_stack, sizeof(_stack), PRIO, 0,
+                                     _tx_loop, NULL, "ndn-prio-tx");
+    assert(pid > 0);
+    _tx_thread = (thread_t *)thread_get(pid);
+    _timer.callback = _wakeup;
+    _timer.arg = NULL;
+
+    ndn_tap_set_tx_hook(_enqueue);
+}
+
+int ndn_prio_add(const char *prefix, unsigned cls)
+{
+    uint8_t name[NDN_PRIO_PREFIX_MAXLEN];
+    int len = ndn_tap_uri_to_name(prefix, name, sizeof(name));
+    prefix_t *slot = NULL;
+
+    if ((len <= 0) || (cls >= NDN_PRIO_CLS_NUMOF)) {
+        return -1;
+    }
+
+    mutex_lock(&_lock);
+    for (unsigned i = 0; i < NDN_PRIO_PREFIX_NUMOF; i++) {
+        prefix_t *p = &_prefixes[i];
+        if ((p->len == len) && (memcmp(p->name, name, len) == 0)) {
+            slot = p;
+            break;
+        }
+        if ((slot == NULL) && (p->len == 0)) {
+            slot = p;
+        }
+    }
+    if (slot) {
+        memcpy(slot->name, name, len);
+        slot->len = (uint8_t)len;
+        slot->cls = (uint8_t)cls;
+    }
+    mutex_unlock(&_lock);
+
+    return (slot) ? 0 : -1;
+}
+
+int ndn_prio_del(const char *prefix)
+{
+    uint8_t name[NDN_PRIO_PREFIX_MAXLEN];
+    int len = ndn_tap_uri_to_name(prefix, name, sizeof(name));
+    int res = -1;
+
+    if (len <= 0) {
+        return -1;
+    }
+
+    mutex_lock(&_lock);
+    for (unsigned i = 0; i < NDN_PRIO_PREFIX_NUMOF; i++) {
+        prefix_t *p = &_prefixes[i];
+        if ((p->len == len) && (memcmp(p->name, name, len) == 0)) {
+            p->len = 0;
+            res = 0;
+        }
+    }
+    mutex_unlock(&_lock);
+
+    return res;
+}
+
+static void _print(void)
+{
+    mutex_lock(&_lock);
+    printf("prio: mode %s, ", (_mode == NDN_PRIO_STRICT) ? "strict" : "wrr");
+    if (_burst == 0) {
+        puts("no pacing");
+    }
+    else {
+        printf("%u packets per connection interval (default %lums)\n",
+               _burst, (unsigned long)(_itvl / US_PER_MS));
+    }
+    for (unsigned i = 0; i < NDN_PRIO_PREFIX_NUMOF; i++) {
+        prefix_t *p = &_prefixes[i];
+        if (p->len == 0) {
+            continue;
+        }
+        ndn_tap_pkt_t pkt = { .name = p->name, .name_len = p->len };
+        char uri[NDN_PRIO_PREFIX_MAXLEN + 1];
+        ndn_tap_name_to_uri(&pkt, uri, sizeof(uri));
+        printf("  %s -> class %u\n", uri, (unsigned)p->cls);
+    }
+    printf("%5s %6s %6s %8s %8s %6s %6s %10s %10s\n", "class", "weight",
+           "depth", "enq", "sent", "drop", "max", "avg [us]", "max [us]");
+    for (unsigned i = 0; i < NDN_PRIO_CLS_NUMOF; i++) {
+        cls_stats_t *s = &_stats[i];
+        uint32_t avg = (s->sent) ? (uint32_t)(s->delay_sum / s->sent) : 0;
+        printf("%5u %6u %6u %8lu %8lu %6lu %6u %10lu %10lu\n", i, _weight[i],
+               _q[i].len, (unsigned long)s->enq, (unsigned long)s->sent,
+               (unsigned long)s->drop, s->max_len, (unsigned long)avg,
+               (unsigned long)s->delay_max);
+    }
+    mutex_unlock(&_lock);
+}
+
+int ndn_prio_cmd(int argc, char **argv)
+{
+    if (argc < 2) {
+        _print();
+        return 0;
+    }
+
+    if ((strcmp(argv[1], "add") == 0) && (argc > 3)) {
+        if (ndn_prio_add(argv[2], (unsigned)atoi(argv[3])) != 0) {
+            puts("err: unable to add prefix");
+            return 1;
+        }
+    }
+    else if ((strcmp(argv[1], "del") == 0) && (argc > 2)) {
+        if (ndn_prio_del(argv[2]) != 0) {
+            puts("err: prefix not configured");
+            return 1;
+        }
+    }
+    else if ((strcmp(argv[1], "mode") == 0) && (argc > 2)) {
+        mutex_lock(&_lock);
+        _mode = (strcmp(argv[2], "wrr") == 0) ? NDN_PRIO_WRR : NDN_PRIO_STRICT;
+        mutex_unlock(&_lock);
+    }
+    else if ((strcmp(argv[1], "weight") == 0) && (argc > 3)) {
+        unsigned cls = (unsigned)atoi(argv[2]);
+        int weight = atoi(argv[3]);
+        if ((cls >= NDN_PRIO_CLS_NUMOF) || (weight <= 0)) {
+            puts("err: invalid class or weight");
+            return 1;
+        }
+        mutex_lock(&_lock);
+        _weight[cls] = (unsigned)weight;
+        mutex_unlock(&_lock);
+    }
+    else if ((strcmp(argv[1], "pace") == 0) && (argc > 2)) {
+        mutex_lock(&_lock);
+        _burst = (unsigned)atoi(argv[2]);
+        if (argc > 3) {
+            _itvl = (uint32_t)atoi(argv[3]) * US_PER_MS;
+        }
+        /* re-evaluate all connections with the new limits */
+        memset(_dests, 0, sizeof(_dests));
+        mutex_unlock(&_lock);
+        thread_flags_set(_tx_thread, FLAG_TX);
+    }
+    else if (strcmp(argv[1], "reset") == 0) {
+        mutex_lock(&_lock);
+        memset(_stats, 0, sizeof(_stats));
+        mutex_unlock(&_lock);
+    }
+    else {
+        printf("usage: %s [add <prefix> <class>|del <prefix>|mode strict|wrr"
+               "|weight <class> <weight>|pace <burst> [<itvl ms>]|reset]\n",
+               argv[0]);
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,251 @@
+/*
+ * Copyright (C) 2019 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @defgroup    ndn_tap NDN packet tap
+ * @brief       Observe all NDN packets passing CCN-lite's link layer boundary
+ *
+ * This module wraps `ccnl_core_RX()` and `ccnl_ll_TX()` (using the linker's
+ * `--wrap` feature) and hands every packet received or sent by the local
+ * CCN-lite relay to a list of registered listeners. This way we can hook into
+ * the forwarder without patching CCN-lite itself.
+ *
+ * Additionally, a single transmit hook can take over outgoing packets, e.g. to
+ * queue and schedule them before they are passed on to the link layer.
+ *
+ * Listeners are called for received packets in the context of the CCN-lite
+ * thread. Sent packets are reported from the thread that passes them to the
+ * link layer: the CCN-lite thread without a transmit hook, otherwise the
+ * thread calling ndn_tap_tx() (e.g. the @ref ndn_prio transmit thread). So
+ * keep listeners short, and protect state they share with other threads.
+ *
+ * @{
+ *
+ * @file
+ * @brief       NDN packet tap interface
+ *
+ * @author      Hauke Petersen <hauke.petersen@fu-berlin.de>
+ */
+
+#ifndef NDN_TAP_H
+#define NDN_TAP_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "ccn-lite-riot.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief   Maximum length of a URI passed to ndn_tap_uri_to_prefix()
+ */
+#ifndef NDN_TAP_URI_MAXLEN
+#define NDN_TAP_URI_MAXLEN      (64U)
+#endif
+
+/**
+ * @brief   Packet direction
+ */
+typedef enum {
+    NDN_TAP_RX,                 /**< packet was received */
+    NDN_TAP_TX,                 /**< packet is sent */
+} ndn_tap_dir_t;
+
+/**
+ * @brief   Traffic classes we distinguish
+ */
+typedef enum {
+    NDN_TAP_CLS_INTEREST,       /**< NDN Interest packets */
+    NDN_TAP_CLS_DATA,           /**< NDN Data packets */
+    NDN_TAP_CLS_OTHER,          /**< anything else (NACKs, garbage, ...) */
+    NDN_TAP_CLS_NUMOF,          /**< number of traffic classes */
+} ndn_tap_cls_t;
+
+/**
+ * @brief   Packet event as passed to the listeners
+ */
+typedef struct {
+    ndn_tap_dir_t dir;          /**< direction of the packet */
+    ndn_tap_cls_t cls;          /**< traffic class of the packet */
+    const uint8_t *data;        /**< raw NDN-TLV encoded packet */
+    size_t len;                 /**< length of @p data in bytes */
+    uint32_t time;              /**< time the event started [us] */
+    uint32_t cpu_us;            /**< CPU time spent on the packet, for RX
+                                     *   without the packets sent meanwhile */
+} ndn_tap_evt_t;
+
+/**
+ * @brief   Parsed view into a raw NDN-TLV packet
+ */
+typedef struct {
+    const uint8_t *name;        /**< value of the Name TLV (the components) */
+    size_t name_len;            /**< length of @p name in bytes */
+    const uint8_t *content;     /**< value of the Content TLV (Data only) */
+    size_t content_len;         /**< length of @p content in bytes */
+} ndn_tap_pkt_t;
+
+/**
+ * @brief   Listener callback signature
+ */
+typedef void (*ndn_tap_cb_t)(const ndn_tap_evt_t *evt, void *arg);
+
+/**
+ * @brief   Listener context
+ */
+typedef struct ndn_tap {
+    struct ndn_tap *next;       /**< next listener in the list */
+    ndn_tap_cb_t cb;            /**< callback to call for each packet */
+    void *arg;                  /**< user argument passed to @p cb */
+} ndn_tap_t;
+
+/**
+ * @brief   Transmit hook signature
+ *
+ * A transmit hook takes over all packets CCN-lite hands to the link layer. It
+ * must copy whatever it needs from @p buf, as @p buf is freed by CCN-lite once
+ * the hook returns. Packets are eventually sent using ndn_tap_tx().
+ */
+typedef void (*ndn_tap_tx_hook_t)(struct ccnl_relay_s *relay,
+                                  struct ccnl_if_s *ifc, sockunion *dest,
+                                  struct ccnl_buf_s *buf);
+
+/**
+ * @brief   Register a listener
+ *
+ * @note    Listeners must be registered before any NDN traffic is processed,
+ *          i.e. before calling ccnl_start().
+ *
+ * @param[in] tap       listener to add, must be valid for the lifetime of
+ *                      the application
+ */
+void ndn_tap_register(ndn_tap_t *tap);
+
+/**
+ * @brief   Set the transmit hook, only one hook is supported
+ *
+ * @note    Must be called before CCN-lite is started.
+ *
+ * @param[in] hook      transmit hook, NULL to send packets directly
+ */
+void ndn_tap_set_tx_hook(ndn_tap_tx_hook_t hook);
+
+/**
+ * @brief   Pass a packet to the link layer and notify all listeners
+ *
+ * This is what CCN-lite's ccnl_ll_TX() does when no transmit hook is set.
+ * Listeners are notified in the context of the calling thread.
+ *
+ * @param[in] relay     CCN-lite relay
+ * @param[in] ifc       interface to send the packet on
+ * @param[in] dest      link layer destination
+ * @param[in] buf       packet to send
+ */
+void ndn_tap_tx(struct ccnl_relay_s *relay, struct ccnl_if_s *ifc,
+                sockunion *dest, struct ccnl_buf_s *buf);
+
+/**
+ * @brief   Get the traffic class of the given NDN-TLV encoded packet
+ *
+ * @param[in] data      raw packet
+ * @param[in] len       length of @p data in bytes
+ *
+ * @return  traffic class of the packet
+ */
+ndn_tap_cls_t ndn_tap_classify(const uint8_t *data, size_t len);
+
+/**
+ * @brief   Locate name and content of the given NDN-TLV encoded packet
+ *
+ * The packet is not copied, all pointers in @p pkt point into @p data.
+ *
+ * @param[in] data      raw Interest or Data packet
+ * @param[in] len       length of @p data in bytes
+ * @param[out] pkt      parsed packet
+ *
+ * @return  0 on success
+ * @return  -1 if @p data is not a valid Interest or Data packet
+ */
+int ndn_tap_parse(const uint8_t *data, size_t len, ndn_tap_pkt_t *pkt);
+
+/**
+ * @brief   Read type and length of the NDN-TLV element at @p pos
+ *
+ * On success, @p pos points to the value of the element, which is guaranteed
+ * to fit into the buffer.
+ *
+ * @param[in,out] pos   current position in the buffer
+ * @param[in] end       end of the buffer
+ * @param[out] type     TLV type
+ * @param[out] len      TLV length
+ *
+ * @return  0 on success
+ * @return  -1 if the element is malformed or exceeds the buffer
+ */
+int ndn_tap_tlv(const uint8_t **pos, const uint8_t *end,
+                uint32_t *type, uint32_t *len);
+
+/**
+ * @brief   Write the name of a parsed packet as URI (e.g. `/foo/bar`)
+ *
+ * Names that do not fit into @p buf are truncated.
+ *
+ * @param[in] pkt       parsed packet
+ * @param[out] buf      target buffer, always '\0' terminated
+ * @param[in] size      size of @p buf in bytes, must be > 0
+ *
+ * @return  length of the resulting string
+ */
+size_t ndn_tap_name_to_uri(const ndn_tap_pkt_t *pkt, char *buf, size_t size);
+
+/**
+ * @brief   Encode a URI (e.g. `/foo/bar`) into the value of a Name TLV
+ *
+ * The result can be compared bytewise to ndn_tap_pkt_t::name: a name
+ * starts with a given prefix, if its first bytes equal the encoded prefix.
+ *
+ * @param[in] uri       name as URI
+ * @param[out] buf      target buffer
+ * @param[in] size      size of @p buf in bytes
+ *
+ * @return  length of the encoded name
+ * @return  -1 if @p buf is too small or @p uri is invalid
+ */
+int ndn_tap_uri_to_name(const char *uri, uint8_t *buf, size_t size);
+
+/**
+ * @brief   Convert a URI into a CCN-lite prefix, leaving @p uri untouched
+ *
+ * ccnl_URItoPrefix() overwrites the '/' separators of the string it is given,
+ * so converting the same string twice yields a prefix of its first component
+ * only. This function converts a copy of @p uri instead.
+ *
+ * @param[in] uri       name as URI, at most NDN_TAP_URI_MAXLEN characters
+ *
+ * @return  prefix, to be freed using ccnl_prefix_free()
+ * @return  NULL if @p uri is too long or out of memory
+ */
+struct ccnl_prefix_s *ndn_tap_uri_to_prefix(const char *uri);
+
+/**
+ * @brief   Get a human readable name for the given traffic class
+ *
+ * @param[in] cls       traffic class
+ *
+ * @return  name of the class
+ */
+const char *ndn_tap_cls_str(ndn_tap_cls_t cls);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* NDN_TAP_H */
+/** @} */
@@ -0,0 +1,271 @@
+/*
+ * Copyright (C) 2019 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     ndn_tap
+ * @{
+ *
+ * @file
+ * @brief       NDN packet tap implementation
+ *
+ * @author      Hauke Petersen <hauke.petersen@fu-berlin.de>
+ *
+ * @}
+ */
+
+#include <string.h>
+
+#include "thread.h"
+#include "xtimer.h"
+
+#include "ndn_tap.h"
+
+/* the original CCN-lite functions, resolved by the linker (--wrap) */
+void __real_ccnl_core_RX(struct ccnl_relay_s *relay, int ifndx, uint8_t *data,
+                         size_t datalen, struct sockaddr *sa, size_t addrlen);
+void __real_ccnl_ll_TX(struct ccnl_relay_s *relay, struct ccnl_if_s *ifc,
+                       sockunion *dest, struct ccnl_buf_s *buf);
+
+/* NDN-TLV types we need to find our way through a packet */
+#define TLV_NAME                (0x07)
+#define TLV_COMPONENT           (0x08)
+#define TLV_CONTENT             (0x15)
+
+static ndn_tap_t *_taps = NULL;
+static ndn_tap_tx_hook_t _tx_hook = NULL;
+
+/* packets sent while CCN-lite handles a received one are accounted on their
+ * own, so their time is taken out of the RX packet's CPU time */
+static kernel_pid_t _rx_pid = KERNEL_PID_UNDEF;
+static uint32_t _rx_tx_us;
+
+static const char *_cls_str[] = { "interest", "data", "other" };
+
+/* read a NDN-TLV variable length number */
+static int _tlv_num(const uint8_t **pos, const uint8_t *end, uint32_t *num)
+{
+    const uint8_t *p = *pos;
+    size_t n;
+
+    if (p >= end) {
+        return -1;
+    }
+    if (*p < 253) {
+        *num = *p;
+        *pos = p + 1;
+        return 0;
+    }
+    else if (*p == 253) {
+        n = 2;
+    }
+    else if (*p == 254) {
+        n = 4;
+    }
+    else {
+        return -1;      /* 64-bit numbers are of no use for us */
+    }
+
+    if ((size_t)(end - p) < (n + 1)) {
+        return -1;
+    }
+    *num = 0;
+    for (size_t i = 1; i <= n; i++) {
+        *num = (*num << 8) | p[i];
+    }
+    *pos = p + n + 1;
+    return 0;
+}
+
+int ndn_tap_tlv(const uint8_t **pos, const uint8_t *end,
+                uint32_t *type, uint32_t *len)
+{
+    if ((_tlv_num(pos, end, type) != 0) || (_tlv_num(pos, end, len) != 0) ||
+        (*len > (size_t)(end - *pos))) {
+        return -1;
+    }
+    return 0;
+}
+
+static void _notify(ndn_tap_dir_t dir, const uint8_t *data, size_t len,
+                    uint32_t time, uint32_t cpu_us)
+{
+    ndn_tap_evt_t evt = {
+        .dir = dir,
+        .cls = ndn_tap_classify(data, len),
+        .data = data,
+        .len = len,
+        .time = time,
+        .cpu_us = cpu_us,
+    };
+
+    for (ndn_tap_t *tap = _taps; tap; tap = tap->next) {
+        tap->cb(&evt, tap->arg);
+    }
+}
+
+void __wrap_ccnl_core_RX(struct ccnl_relay_s *relay, int ifndx, uint8_t *data,
+                         size_t datalen, struct sockaddr *sa, size_t addrlen)
+{
+    _rx_pid = thread_getpid();
+    _rx_tx_us = 0;
+    uint32_t start = xtimer_now_usec();
+    __real_ccnl_core_RX(relay, ifndx, data, datalen, sa, addrlen);
+    uint32_t cpu_us = (xtimer_now_usec() - start) - _rx_tx_us;
+    _rx_pid = KERNEL_PID_UNDEF;
+    /* CCN-lite parses the packet in place, so data is still valid here */
+    _notify(NDN_TAP_RX, data, datalen, start, cpu_us);
+}
+
+void __wrap_ccnl_ll_TX(struct ccnl_relay_s *relay, struct ccnl_if_s *ifc,
+                       sockunion *dest, struct ccnl_buf_s *buf)
+{
+    if (_tx_hook) {
+        _tx_hook(relay, ifc, dest, buf);
+    }
+    else {
+        ndn_tap_tx(relay, ifc, dest, buf);
+    }
+}
+
+void ndn_tap_tx(struct ccnl_relay_s *relay, struct ccnl_if_s *ifc,
+                sockunion *dest, struct ccnl_buf_s *buf)
+{
+    uint32_t start = xtimer_now_usec();
+    __real_ccnl_ll_TX(relay, ifc, dest, buf);
+    uint32_t cpu_us = xtimer_now_usec() - start;
+    if (thread_getpid() == _rx_pid) {
+        _rx_tx_us += cpu_us;
+    }
+    _notify(NDN_TAP_TX, buf->data, buf->datalen, start, cpu_us);
+}
+
+void ndn_tap_set_tx_hook(ndn_tap_tx_hook_t hook)
+{
+    _tx_hook = hook;
+}
+
+void ndn_tap_register(ndn_tap_t *tap)
+{
+    tap->next = _taps;
+    _taps = tap;
+}
+
+ndn_tap_cls_t ndn_tap_classify(const uint8_t *data, size_t len)
+{
+    if (len == 0) {
+        return NDN_TAP_CLS_OTHER;
+    }
+
+    switch (data[0]) {
+        case NDN_TLV_Interest:
+            return NDN_TAP_CLS_INTEREST;
+        case NDN_TLV_Data:
+            return NDN_TAP_CLS_DATA;
+        default:
+            return NDN_TAP_CLS_OTHER;
+    }
+}
+
+int ndn_tap_parse(const uint8_t *data, size_t len, ndn_tap_pkt_t *pkt)
+{
+    const uint8_t *pos = data;
+    const uint8_t *end = data + len;
+    uint32_t type, tlen;
+
+    memset(pkt, 0, sizeof(*pkt));
+
+    if ((ndn_tap_tlv(&pos, end, &type, &tlen) != 0) ||
+        ((type != NDN_TLV_Interest) && (type != NDN_TLV_Data))) {
+        return -1;
+    }
+    end = pos + tlen;
+
+    /* the name is always the first element */
+    if ((ndn_tap_tlv(&pos, end, &type, &tlen) != 0) || (type != TLV_NAME)) {
+        return -1;
+    }
+    pkt->name = pos;
+    pkt->name_len = tlen;
+    pos += tlen;
+
+    /* for Data, skip the optional MetaInfo to get to the content */
+    while (pos < end) {
+        if (ndn_tap_tlv(&pos, end, &type, &tlen) != 0) {
+            return -1;
+        }
+        if (type == TLV_CONTENT) {
+            pkt->content = pos;
+            pkt->content_len = tlen;
+            break;
+        }
+        pos += tlen;
+    }
+
+    return 0;
+}
+
+size_t ndn_tap_name_to_uri(const ndn_tap_pkt_t *pkt, char *buf, size_t size)
+{
+    const uint8_t *pos = pkt->name;
+    const uint8_t *end = pkt->name + pkt->name_len;
+    uint32_t type, tlen;
+    size_t res = 0;
+
+    while ((pos < end) && (ndn_tap_tlv(&pos, end, &type, &tlen) == 0)) {
+        if ((type == TLV_COMPONENT) && (res < (size - 1))) {
+            buf[res++] = '/';
+            for (uint32_t i = 0; (i < tlen) && (res < (size - 1)); i++) {
+                buf[res++] = (char)pos[i];
+            }
+        }
+        pos += tlen;
+    }
+    buf[res] = '\0';
+
+    return res;
+}
+
+int ndn_tap_uri_to_name(const char *uri, uint8_t *buf, size_t size)
+{
+    size_t pos = 0;
+
+    while (*uri) {
+        if (*uri == '/') {
+            uri++;
+            continue;
+        }
+        size_t len = strcspn(uri, "/");
+        if ((len >= 253) || ((pos + len + 2) > size)) {
+            return -1;
+        }
+        buf[pos++] = TLV_COMPONENT;
+        buf[pos++] = (uint8_t)len;
+        memcpy(&buf[pos], uri, len);
+        pos += len;
+        uri += len;
+    }
+
+    return (int)pos;
+}
+
+struct ccnl_prefix_s *ndn_tap_uri_to_prefix(const char *uri)
+{
+    char tmp[NDN_TAP_URI_MAXLEN + 1];
+    size_t len = strlen(uri);
+
+    if (len > NDN_TAP_URI_MAXLEN) {
+        return NULL;
+    }
+    memcpy(tmp, uri, len + 1);
+    return ccnl_URItoPrefix(tmp, CCNL_SUITE_NDNTLV, NULL);
+}
+
+const char *ndn_tap_cls_str(ndn_tap_cls_t cls)
+{
+    return _cls_str[cls];
+}
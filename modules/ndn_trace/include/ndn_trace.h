@@ -0,0 +1,163 @@
+/*
+ * Copyright (C) 2019 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @defgroup    ndn_trace NDN traffic trace capture
+ * @brief       Record a compact, timestamped trace of a node's NDN workload
+ *
+ * The trace contains all Interests and Data passing the local CCN-lite relay
+ * (captured using @ref ndn_tap) as well as application level events like GATT
+ * writes and subscriptions that are added explicitly by the application.
+ *
+ * Records are stored back-to-back in a static buffer. Once the buffer is full,
+ * further records are dropped (and counted), so a trace always covers the
+ * start of a workload.
+ *
+ * `trace dump` prints the trace as a list of `replay add ...` shell commands,
+ * so it can directly be piped into the `fw_replay` firmware. Recording
+ * continues while dumping, records added meanwhile are part of the next dump.
+ *
+ * @{
+ *
+ * @file
+ * @brief       NDN trace capture interface
+ *
+ * @author      Hauke Petersen <hauke.petersen@fu-berlin.de>
+ */
+
+#ifndef NDN_TRACE_H
+#define NDN_TRACE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief   Size of the trace buffer in bytes
+ */
+#ifndef NDN_TRACE_BUFSIZE
+#define NDN_TRACE_BUFSIZE       (4096U)
+#endif
+
+/**
+ * @brief   Maximum name length stored per record, longer names are truncated
+ */
+#ifndef NDN_TRACE_NAMELEN
+#define NDN_TRACE_NAMELEN       (48U)
+#endif
+
+/**
+ * @brief   Number of outstanding Interests tracked to detect retransmissions
+ */
+#ifndef NDN_TRACE_PENDING_NUMOF
+#define NDN_TRACE_PENDING_NUMOF (8U)
+#endif
+
+/**
+ * @brief   Time an Interest counts as outstanding if no Data arrives [us]
+ *
+ * Defaults to CCN-lite's Interest lifetime, sending the same name again within
+ * this time is a retransmission by CCN-lite and not recorded.
+ */
+#ifndef NDN_TRACE_PENDING_TIMEOUT
+#define NDN_TRACE_PENDING_TIMEOUT   (10U * 1000U * 1000U)
+#endif
+
+/**
+ * @brief   Trace record types
+ */
+typedef enum {
+    NDN_TRACE_GATT_WRITE,       /**< name written by a GATT client */
+    NDN_TRACE_GATT_SUB,         /**< GATT subscription changed, arg: state */
+    NDN_TRACE_INT_TX,           /**< Interest sent, without retransmissions */
+    NDN_TRACE_INT_RX,           /**< Interest received */
+    NDN_TRACE_DATA_TX,          /**< Data sent, arg: content length */
+    NDN_TRACE_DATA_RX,          /**< Data received, arg: content length */
+    NDN_TRACE_NUMOF,            /**< number of record types */
+} ndn_trace_type_t;
+
+/**
+ * @brief   Initialize trace capture
+ *
+ * @note    Must be called before CCN-lite is started. Recording is started
+ *          using ndn_trace_start() or the `trace start` shell command.
+ */
+void ndn_trace_init(void);
+
+/**
+ * @brief   Clear the trace buffer and start recording
+ *
+ * @note    Must be called from the same thread as ndn_trace_cmd(), as the
+ *          trace is printed without holding its lock.
+ */
+void ndn_trace_start(void);
+
+/**
+ * @brief   Stop recording
+ */
+void ndn_trace_stop(void);
+
+/**
+ * @brief   Add a record to the trace
+ *
+ * Does nothing if recording is stopped.
+ *
+ * @param[in] type      record type
+ * @param[in] arg       type specific argument
+ * @param[in] name      NDN name (or any other string) of the record
+ */
+void ndn_trace_add(ndn_trace_type_t type, uint16_t arg, const char *name);
+
+/**
+ * @brief   Get the string representation of a record type
+ *
+ * @param[in] type      record type
+ *
+ * @return  name of the record type
+ */
+const char *ndn_trace_type_str(ndn_trace_type_t type);
+
+/**
+ * @brief   Parse a record type from its string representation
+ *
+ * @param[in] str       name of the record type
+ *
+ * @return  record type
+ * @return  NDN_TRACE_NUMOF if @p str is not a valid record type
+ */
+ndn_trace_type_t ndn_trace_type_from_str(const char *str);
+
+/**
+ * @brief   Decode a name as printed by `trace dump` in place
+ *
+ * The dump escapes spaces, '%' and non printable characters as %XX, so every
+ * name is exactly one shell argument.
+ *
+ * @param[in,out] name  escaped name, holds the original name on return
+ */
+void ndn_trace_unescape(char *name);
+
+/**
+ * @brief   Shell command for controlling and dumping the trace
+ *
+ * @param[in] argc      number of arguments
+ * @param[in] argv      arguments
+ *
+ * @return  0 on success, 1 on error
+ */
+int ndn_trace_cmd(int argc, char **argv);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* NDN_TRACE_H */
+/** @} */
@@ -0,0 +1,296 @@
+/*
+ * Copyright (C) 2019 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     ndn_trace
+ * @{
+ *
+ * @file
+ * @brief       NDN trace capture implementation
+ *
+ * @author      Hauke Petersen <hauke.petersen@fu-berlin.de>
+ *
+ * @}
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mutex.h"
+#include "xtimer.h"
+#include "ndn_tap.h"
+
+#include "ndn_trace.h"
+
+/* records are stored as: time [us, 4 byte], type, arg [2 byte], name length
+ * and the (not '\0' terminated) name */
+#define REC_HDR_LEN             (8U)
+
+static uint8_t _buf[NDN_TRACE_BUFSIZE];
+static size_t _pos = 0;
+static unsigned _dropped = 0;
+static int _active = 0;
+static uint32_t _t_start;
+static mutex_t _lock = MUTEX_INIT;
+
+static ndn_tap_t _tap;
+
+/* Interests sent without Data received so far, identified by a hash of their
+ * name, used to tell CCN-lite's retransmissions apart from new Interests */
+static struct {
+    uint32_t hash;
+    uint32_t sent;
+} _pending[NDN_TRACE_PENDING_NUMOF];
+static unsigned _retrans = 0;
+
+static const char *_type_str[] = {
+    "gatt-write", "gatt-sub", "int-tx", "int-rx", "data-tx", "data-rx"
+};
+
+static uint32_t _hash(const char *name)
+{
+    uint32_t hash = 5381;
+    while (*name) {
+        hash = (hash * 33) ^ (uint8_t)*name++;
+    }
+    return hash;
+}
+
+/* must be called with _lock held */
+static int _pending_find(uint32_t hash, uint32_t now)
+{
+    for (unsigned i = 0; i < NDN_TRACE_PENDING_NUMOF; i++) {
+        if (_pending[i].hash && (_pending[i].hash == hash) &&
+            ((now - _pending[i].sent) < NDN_TRACE_PENDING_TIMEOUT)) {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+/* returns 1 if the Interest is a retransmission of an outstanding one */
+static int _int_sent(const char *name, uint32_t now)
+{
+    uint32_t hash = _hash(name) | 1;    /* 0 marks a free slot */
+    int res = 0;
+
+    mutex_lock(&_lock);
+    if (_pending_find(hash, now) >= 0) {
+        _retrans++;
+        res = 1;
+    }
+    else {
+        /* use a free slot or the one of the oldest Interest */
+        unsigned slot = 0;
+        for (unsigned i = 0; i < NDN_TRACE_PENDING_NUMOF; i++) {
+            if (_pending[i].hash == 0) {
+                slot = i;
+                break;
+            }
+            if ((now - _pending[i].sent) > (now - _pending[slot].sent)) {
+                slot = i;
+            }
+        }
+        _pending[slot].hash = hash;
+        _pending[slot].sent = now;
+    }
+    mutex_unlock(&_lock);
+
+    return res;
+}
+
+static void _data_received(const char *name, uint32_t now)
+{
+    mutex_lock(&_lock);
+    int slot = _pending_find((_hash(name) | 1), now);
+    if (slot >= 0) {
+        _pending[slot].hash = 0;
+    }
+    mutex_unlock(&_lock);
+}
+
+static void _on_pkt(const ndn_tap_evt_t *evt, void *arg)
+{
+    (void)arg;
+    ndn_tap_pkt_t pkt;
+    char name[NDN_TRACE_NAMELEN + 1];
+
+    if (!_active || (ndn_tap_parse(evt->data, evt->len, &pkt) != 0)) {
+        return;
+    }
+    ndn_tap_name_to_uri(&pkt, name, sizeof(name));
+
+    if (evt->cls == NDN_TAP_CLS_INTEREST) {
+        if ((evt->dir == NDN_TAP_TX) && _int_sent(name, evt->time)) {
+            return;
+        }
+        ndn_trace_add((evt->dir == NDN_TAP_TX) ? NDN_TRACE_INT_TX
+                                               : NDN_TRACE_INT_RX, 0, name);
+    }
+    else if (evt->cls == NDN_TAP_CLS_DATA) {
+        if (evt->dir == NDN_TAP_RX) {
+            _data_received(name, evt->time);
+        }
+        ndn_trace_add((evt->dir == NDN_TAP_TX) ? NDN_TRACE_DATA_TX
+                                               : NDN_TRACE_DATA_RX,
+                      (uint16_t)pkt.content_len, name);
+    }
+}
+
+void ndn_trace_init(void)
+{
+    _tap.cb = _on_pkt;
+    _tap.arg = NULL;
+    ndn_tap_register(&_tap);
+}
+
+void ndn_trace_start(void)
+{
+    mutex_lock(&_lock);
+    _pos = 0;
+    _dropped = 0;
+    _retrans = 0;
+    memset(_pending, 0, sizeof(_pending));
+    _t_start = xtimer_now_usec();
+    _active = 1;
+    mutex_unlock(&_lock);
+}
+
+void ndn_trace_stop(void)
+{
+    mutex_lock(&_lock);
+    _active = 0;
+    mutex_unlock(&_lock);
+}
+
+void ndn_trace_add(ndn_trace_type_t type, uint16_t arg, const char *name)
+{
+    uint32_t now = xtimer_now_usec();
+    size_t len = strlen(name);
+    if (len > NDN_TRACE_NAMELEN) {
+        len = NDN_TRACE_NAMELEN;
+    }
+
+    mutex_lock(&_lock);
+    if (!_active) {
+        mutex_unlock(&_lock);
+        return;
+    }
+    if ((_pos + REC_HDR_LEN + len) > sizeof(_buf)) {
+        _dropped++;
+        mutex_unlock(&_lock);
+        return;
+    }
+
+    uint32_t time = now - _t_start;
+    uint8_t *rec = &_buf[_pos];
+    memcpy(rec, &time, sizeof(time));
+    rec[4] = (uint8_t)type;
+    memcpy(&rec[5], &arg, sizeof(arg));
+    rec[7] = (uint8_t)len;
+    memcpy(&rec[REC_HDR_LEN], name, len);
+    _pos += REC_HDR_LEN + len;
+    mutex_unlock(&_lock);
+}
+
+const char *ndn_trace_type_str(ndn_trace_type_t type)
+{
+    return (type < NDN_TRACE_NUMOF) ? _type_str[type] : "unknown";
+}
+
+ndn_trace_type_t ndn_trace_type_from_str(const char *str)
+{
+    for (unsigned i = 0; i < NDN_TRACE_NUMOF; i++) {
+        if (strcmp(str, _type_str[i]) == 0) {
+            return (ndn_trace_type_t)i;
+        }
+    }
+    return NDN_TRACE_NUMOF;
+}
+
+void ndn_trace_unescape(char *name)
+{
+    char *out = name;
+
+    while (*name) {
+        if ((name[0] == '%') && name[1] && name[2]) {
+            char hex[3] = { name[1], name[2], '\0' };
+            *out++ = (char)strtoul(hex, NULL, 16);
+            name += 3;
+        }
+        else {
+            *out++ = *name++;
+        }
+    }
+    *out = '\0';
+}
+
+/* print a name as a single shell argument */
+static void _print_name(const uint8_t *name, size_t len)
+{
+    for (size_t i = 0; i < len; i++) {
+        if ((name[i] <= ' ') || (name[i] >= 0x7f) || (name[i] == '%')) {
+            printf("%%%02X", (unsigned)name[i]);
+        }
+        else {
+            putchar(name[i]);
+        }
+    }
+}
+
+/* records are only ever appended, so everything below the current end stays
+ * untouched while printing and the lock is needed to read that end only */
+static void _dump(void)
+{
+    mutex_lock(&_lock);
+    size_t end = _pos;
+    mutex_unlock(&_lock);
+
+    for (size_t pos = 0; pos < end;) {
+        uint8_t *rec = &_buf[pos];
+        uint32_t time;
+        uint16_t arg;
+        memcpy(&time, rec, sizeof(time));
+        memcpy(&arg, &rec[5], sizeof(arg));
+        printf("replay add %lu %s %u ", (unsigned long)time,
+               ndn_trace_type_str(rec[4]), (unsigned)arg);
+        _print_name(&rec[REC_HDR_LEN], rec[7]);
+        puts("");
+        pos += REC_HDR_LEN + rec[7];
+    }
+}
+
+int ndn_trace_cmd(int argc, char **argv)
+{
+    if (argc < 2) {
+        printf("trace: %s, %u of %u bytes used, %u records dropped, "
+               "%u retransmissions skipped\n",
+               (_active) ? "recording" : "stopped", (unsigned)_pos,
+               (unsigned)sizeof(_buf), _dropped, _retrans);
+        return 0;
+    }
+
+    if (strcmp(argv[1], "start") == 0) {
+        ndn_trace_start();
+        puts("trace: recording");
+    }
+    else if (strcmp(argv[1], "stop") == 0) {
+        ndn_trace_stop();
+        puts("trace: stopped");
+    }
+    else if (strcmp(argv[1], "dump") == 0) {
+        _dump();
+    }
+    else {
+        printf("usage: %s [start|stop|dump]\n", argv[0]);
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,164 @@
+/*
+ * Copyright (C) 2019 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     tests
+ * @{
+ *
+ * @file
+ * @brief       Test keeping the content store index in sync with CCN-lite's
+ *              content store while entries are replaced
+ *
+ * @author      Hauke Petersen <hauke.petersen@fu-berlin.de>
+ *
+ * @}
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "fmt.h"
+#include "mutex.h"
+#include "ccn-lite-riot.h"
+#include "ccnl-producer.h"
+#include "ndn_tap.h"
+#include "ndn_idx.h"
+
+/* fill the content store several times over */
+#define NUMOF                   (CCNL_CACHE_SIZE * 4)
+#define URI_BASE                "/icn19/test/"
+#define URI_MAXLEN              (32U)
+#define URI_RUN                 "/icn19/run"
+
+static unsigned char _buf[CCNL_MAX_PACKET_SIZE];
+static unsigned char _scratchpad[64];
+static mutex_t _done = MUTEX_INIT_LOCKED;
+static unsigned _failed = 0;
+
+static void _uri(unsigned i, char *uri)
+{
+    size_t pos = strlen(URI_BASE);
+    memcpy(uri, URI_BASE, pos);
+    pos += fmt_u32_dec(&uri[pos], i);
+    uri[pos] = '\0';
+}
+
+static int _insert(unsigned i)
+{
+    char uri[URI_MAXLEN];
+    uint8_t payload = (uint8_t)i;
+    size_t offs = sizeof(_buf);
+    size_t reslen = 0;
+    size_t len;
+    uint64_t type;
+
+    _uri(i, uri);
+    struct ccnl_prefix_s *prefix = ndn_tap_uri_to_prefix(uri);
+    if (prefix == NULL) {
+        return -1;
+    }
+    int res = ccnl_ndntlv_prependContent(prefix, &payload, sizeof(payload),
+                                         NULL, NULL, &offs, _buf, &reslen);
+    ccnl_prefix_free(prefix);
+    if (res != 0) {
+        return -1;
+    }
+
+    unsigned char *olddata = &_buf[offs];
+    unsigned char *data = olddata;
+    if ((ccnl_ndntlv_dehead(&data, &reslen, &type, &len) != 0) ||
+        (type != NDN_TLV_Data)) {
+        return -1;
+    }
+    struct ccnl_pkt_s *pkt = ccnl_ndntlv_bytes2pkt(type, olddata, &data, &reslen);
+    if (pkt == NULL) {
+        return -1;
+    }
+    struct ccnl_content_s *c = ccnl_content_new(&pkt);
+    if (c == NULL) {
+        return -1;
+    }
+    if (ccnl_content_add2cache(&ccnl_relay, c) == NULL) {
+        ccnl_content_free(c);
+    }
+    return 0;
+}
+
+static int _in_cs(unsigned i)
+{
+    char uri[URI_MAXLEN];
+    uint8_t name[URI_MAXLEN];
+
+    _uri(i, uri);
+    int len = ndn_tap_uri_to_name(uri, name, sizeof(name));
+    return ((len > 0) && (ndn_idx_cs_get(name, (size_t)len) != NULL));
+}
+
+static void _run(void)
+{
+    for (unsigned i = 0; i < NUMOF; i++) {
+        if (_insert(i) != 0) {
+            printf("err: unable to insert Data %u\n", i);
+            _failed++;
+            continue;
+        }
+
+        unsigned numof = ndn_idx_cs_numof();
+        unsigned found = 0;
+        for (unsigned j = 0; j <= i; j++) {
+            found += _in_cs(j);
+        }
+        if ((numof != (unsigned)ccnl_relay.contentcnt) ||
+            (found != (unsigned)ccnl_relay.contentcnt) ||
+            (ccnl_relay.contentcnt > CCNL_CACHE_SIZE) || !_in_cs(i)) {
+            printf("err: after %u inserts: %u indexed, %u found, CS holds %i\n",
+                   (i + 1), numof, found, ccnl_relay.contentcnt);
+            _failed++;
+        }
+    }
+}
+
+/* the CS may only be changed from CCN-lite's thread, so the test runs in the
+ * local producer, triggered by an Interest for URI_RUN */
+static int _producer(struct ccnl_relay_s *relay, struct ccnl_face_s *from,
+                     struct ccnl_pkt_s *pkt)
+{
+    (void)relay;
+    (void)from;
+    struct ccnl_prefix_s *run = ndn_tap_uri_to_prefix(URI_RUN);
+
+    if (run && (ccnl_prefix_cmp(run, NULL, pkt->pfx, CMP_EXACT) == 0)) {
+        _run();
+        mutex_unlock(&_done);
+    }
+    if (run) {
+        ccnl_prefix_free(run);
+    }
+    return 0;
+}
+
+int main(void)
+{
+    ccnl_core_init();
+    ccnl_start();
+    ccnl_set_local_producer(_producer);
+
+    struct ccnl_prefix_s *prefix = ndn_tap_uri_to_prefix(URI_RUN);
+    if ((prefix == NULL) ||
+        (ccnl_send_interest(prefix, _scratchpad, sizeof(_scratchpad),
+                            NULL) < 0)) {
+        puts("err: unable to start the test");
+        puts("FAILURE");
+        return 0;
+    }
+    ccnl_prefix_free(prefix);
+    mutex_lock(&_done);
+
+    puts((_failed) ? "FAILURE" : "SUCCESS");
+    return 0;
+}